@@ -0,0 +1,234 @@
+#include <cassert>
+#include <vector>
+#include "Bicubic.h"
+#include "ResamplePlan.h"
+#include "ResampleControl.h"
+
+// The planes are processed independently. The rows of all planes
+// are numbered together: the row r is the row r % height
+// of the plane r / height (height of tmp or of the region).
+// The region x0 <= x < x0 + regionWidth, y0 <= y < y0 + regionHeight
+// of the result is computed; tmp holds the source rows
+// srcY0 <= i < srcY0 + height used by it
+struct BicubicPass {
+    int width;
+    int height;
+    int srcY0;
+    const ImageWindow* src;
+    int x0;
+    int y0;
+    int regionWidth;
+    int regionHeight;
+    PlanarImage* tmp;       // Rows of the source interpolated horizontally
+    PlanarImage* dst;
+    const ResamplePlan* planX;      // KERNEL_CUBIC plans of the axes
+    const ResamplePlan* planY;
+    const float* weightsX;          // Weights of planX in floats
+    ResampleControl* control;       // Progress and cancellation, may be 0
+};
+
+// Catmull-Rom weight of the tap 0..3 for the fraction f
+static constexpr double keysWeight(int tap, double f) {
+    return (tap == 0)? 0.5*(-f + 2.*f*f - f*f*f) :
+        (tap == 1)? 0.5*(2. - 5.*f*f + 3.*f*f*f) :
+        (tap == 2)? 0.5*(f + 4.*f*f - 3.*f*f*f) :
+        0.5*(f*f*f - f*f);
+}
+
+// Horizontal pass: the source rows r0 <= r < r1
+static void bicubicRows(const BicubicPass& pass, int r0, int r1) {
+    const int* taps = pass.planX->taps.data();
+    const float* weights = pass.weightsX;
+    int x1 = pass.x0 + pass.regionWidth;
+    for (int r = r0; r < r1; ++r) {
+        if (isCancelled(pass.control))
+            return;
+        int c = r/pass.height;
+        int y = r%pass.height;
+        const float* src = pass.src->row(c, pass.srcY0 + y);
+        float* dst = pass.tmp->row(c, y) - pass.x0;
+        for (int x = pass.x0; x < x1; ++x) {
+            const int* t = taps + 4*x;
+            const float* w = weights + 4*x;
+            dst[x] = w[0]*src[t[0]] + w[1]*src[t[1]] +
+                w[2]*src[t[2]] + w[3]*src[t[3]];
+        }
+        addRowsDone(pass.control, 1);
+    }
+}
+
+// Horizontal pass for the integer zoom Z (stepX == 1/Z): the source
+// pixel i gives the outputs i*Z .. i*Z + Z-1 with the fractions k/Z,
+// so the weights are constants of the unrolled loop over the phases.
+// The outputs of the partial phases at the ends of the region
+// are computed by the same expression
+template <int Z>
+static void bicubicRowsZoom(const BicubicPass& pass, int r0, int r1) {
+    int width = pass.width;
+    float w[Z][4];
+    for (int k = 0; k < Z; ++k) {
+        for (int tap = 0; tap < 4; ++tap)
+            w[k][tap] = (float) keysWeight(tap, (double) k / (double) Z);
+    }
+    int x0 = pass.x0;
+    int x1 = x0 + pass.regionWidth;
+    int i0 = x0/Z;
+    int i1 = (x1 + Z - 1)/Z;
+    for (int r = r0; r < r1; ++r) {
+        if (isCancelled(pass.control))
+            return;
+        int c = r/pass.height;
+        int y = r%pass.height;
+        const float* src = pass.src->row(c, pass.srcY0 + y);
+        float* dst = pass.tmp->row(c, y) - x0;
+        for (int i = i0; i < i1; ++i) {
+            float s0 = src[(i > 0)? i - 1 : 0];
+            float s1 = src[i];
+            float s2 = src[(i + 1 < width)? i + 1 : width - 1];
+            float s3 = src[(i + 2 < width)? i + 2 : width - 1];
+            float* d = dst + Z*i;
+            if (Z*i >= x0 && Z*i + Z <= x1) {
+                for (int k = 0; k < Z; ++k) {
+                    d[k] = w[k][0]*s0 + w[k][1]*s1 +
+                        w[k][2]*s2 + w[k][3]*s3;
+                }
+                continue;
+            }
+            for (int k = 0; k < Z; ++k) {
+                if (Z*i + k >= x0 && Z*i + k < x1) {
+                    d[k] = w[k][0]*s0 + w[k][1]*s1 +
+                        w[k][2]*s2 + w[k][3]*s3;
+                }
+            }
+        }
+        addRowsDone(pass.control, 1);
+    }
+}
+
+// Vertical pass: the output rows r0 <= r < r1, every row is
+// a combination of 4 rows of the horizontal pass
+static void bicubicColumns(const BicubicPass& pass, int r0, int r1) {
+    int length = pass.regionWidth;
+    int srcY0 = pass.srcY0;
+    const int* taps = pass.planY->taps.data();
+    const double* weights = pass.planY->weights.data();
+    for (int r = r0; r < r1; ++r) {
+        if (isCancelled(pass.control))
+            return;
+        int c = r/pass.regionHeight;
+        int y = pass.y0 + r%pass.regionHeight;
+        const int* t = taps + 4*y;
+        const double* w = weights + 4*y;
+        const float* s0 = pass.tmp->row(c, t[0] - srcY0);
+        const float* s1 = pass.tmp->row(c, t[1] - srcY0);
+        const float* s2 = pass.tmp->row(c, t[2] - srcY0);
+        const float* s3 = pass.tmp->row(c, t[3] - srcY0);
+        float w0 = (float) w[0], w1 = (float) w[1];
+        float w2 = (float) w[2], w3 = (float) w[3];
+        float* dst = pass.dst->row(c, y - pass.y0);
+        for (int i = 0; i < length; ++i)
+            dst[i] = restrict01(
+                w0*s0[i] + w1*s1[i] + w2*s2[i] + w3*s3[i]
+            );
+        addRowsDone(pass.control, 1);
+    }
+}
+
+void bicubicInterpolation(
+    const PlanarImage& image,
+    int zoomedWidth, int zoomedHeight,
+    PlanarImage& zoomed,
+    double stepX, double stepY,
+    int numThreads, /* = 0 */
+    ResampleControl* control    /* = 0 */
+) {
+    bicubicRegion(
+        ImageWindow(image), zoomedWidth, zoomedHeight,
+        0, 0, zoomedWidth, zoomedHeight, zoomed,
+        stepX, stepY, numThreads, control
+    );
+}
+
+void bicubicRegion(
+    const ImageWindow& image,
+    int zoomedWidth, int zoomedHeight,
+    int x0, int y0, int regionWidth, int regionHeight,
+    PlanarImage& region,
+    double stepX, double stepY,
+    int numThreads, /* = 0 */
+    ResampleControl* control    /* = 0 */
+) {
+    assert(&region != image.part);
+    assert(
+        0 <= x0 && x0 + regionWidth <= zoomedWidth &&
+        0 <= y0 && y0 + regionHeight <= zoomedHeight
+    );
+    int imageWidth = image.width;
+    int imageHeight = image.height;
+    if (
+        imageWidth <= 0 || imageHeight <= 0 ||
+        regionWidth <= 0 || regionHeight <= 0
+    )
+        return;
+    region.create(regionWidth, regionHeight);
+
+    std::shared_ptr<const ResamplePlan> planX = ResamplePlan::get(
+        KERNEL_CUBIC, imageWidth, zoomedWidth, stepX
+    );
+    std::shared_ptr<const ResamplePlan> planY = ResamplePlan::get(
+        KERNEL_CUBIC, imageHeight, zoomedHeight, stepY
+    );
+    std::vector<float> weightsX(planX->weights.size());
+    for (size_t i = 0; i < weightsX.size(); ++i)
+        weightsX[i] = (float) planX->weights[i];
+
+    // The source rows of the taps of the region (the taps grow
+    // with the output row)
+    int srcY0 = planY->taps[4*y0];
+    int srcY1 = planY->taps[4*(y0 + regionHeight - 1) + 3] + 1;
+    assert(
+        image.contains(
+            planX->taps[4*x0], srcY0,
+            planX->taps[4*(x0 + regionWidth - 1) + 3] + 1 -
+            planX->taps[4*x0],
+            srcY1 - srcY0
+        )
+    );
+    PlanarImage tmp(regionWidth, srcY1 - srcY0);
+    BicubicPass pass;
+    pass.width = imageWidth;
+    pass.height = srcY1 - srcY0;
+    pass.srcY0 = srcY0;
+    pass.src = &image;
+    pass.x0 = x0;
+    pass.y0 = y0;
+    pass.regionWidth = regionWidth;
+    pass.regionHeight = regionHeight;
+    pass.tmp = &tmp;
+    pass.dst = &region;
+    pass.planX = planX.get();
+    pass.planY = planY.get();
+    pass.weightsX = weightsX.data();
+    pass.control = control;
+
+    // The integer zooms 2, 3, 4 have the specialized horizontal pass
+    void (*rows)(const BicubicPass&, int, int) = bicubicRows;
+    for (int z = 2; z <= 4; ++z) {
+        if (zoomedWidth == z*imageWidth && stepX == 1./(double) z) {
+            if (z == 2)
+                rows = bicubicRowsZoom<2>;
+            else if (z == 3)
+                rows = bicubicRowsZoom<3>;
+            else
+                rows = bicubicRowsZoom<4>;
+        }
+    }
+
+    addRowsTotal(control, NUM_PLANES*(pass.height + regionHeight));
+    runThreadRanges(rows, pass, 0, NUM_PLANES*pass.height, numThreads);
+    if (isCancelled(control))
+        return;
+    runThreadRanges(
+        bicubicColumns, pass, 0, NUM_PLANES*regionHeight, numThreads
+    );
+}
@@ -0,0 +1,41 @@
+#ifndef BICUBIC_H
+#define BICUBIC_H
+
+#include "PlanarImage.h"
+
+class ResampleControl;
+
+// Bicubic interpolation with the Catmull-Rom (Keys, a = -0.5) kernel.
+// The output pixel (x, y) is taken at the source position
+// (x*stepX, y*stepY); the kernel is separable, so the rows are
+// interpolated first (with the taps and weights computed once for all
+// rows, see ResamplePlan), then the columns as linear combinations
+// of 4 rows. The source pixels outside the image are replaced by
+// the nearest border pixels; the result is restricted to [0, 1].
+// The planes are processed independently; zoomed is (re)allocated
+// with the size zoomedWidth x zoomedHeight
+void bicubicInterpolation(
+    const PlanarImage& image,
+    int zoomedWidth, int zoomedHeight,
+    PlanarImage& zoomed,
+    double stepX, double stepY,     // Source pixels per output pixel
+    int numThreads = 0,             // 0 -- use all processors
+    ResampleControl* control = 0    // Progress and cancellation
+);
+
+// The part x0 <= x < x0 + regionWidth, y0 <= y < y0 + regionHeight
+// of the result of bicubicInterpolation of the whole image with
+// the same parameters, the pixels are the same as in the whole result;
+// region is (re)allocated with the size regionWidth x regionHeight.
+// Only the source pixels of the taps of the region are read
+void bicubicRegion(
+    const ImageWindow& image,
+    int zoomedWidth, int zoomedHeight,
+    int x0, int y0, int regionWidth, int regionHeight,
+    PlanarImage& region,
+    double stepX, double stepY,
+    int numThreads = 0,
+    ResampleControl* control = 0
+);
+
+#endif
@@ -0,0 +1,131 @@
+#include <cassert>
+#include <vector>
+#include "Bilinear.h"
+#include "ResamplePlan.h"
+#include "ResampleControl.h"
+
+// The rows of all planes of the region are numbered together:
+// the row r is the row y0 + r % regionHeight of the result
+// in the plane r / regionHeight
+struct BilinearPass {
+    const ImageWindow* src;
+    int x0;                 // The region of the result
+    int y0;
+    int regionWidth;
+    int regionHeight;
+    int srcX0;              // The source columns used by the region
+    int srcX1;
+    PlanarImage* dst;
+    const ResamplePlan* planX;      // KERNEL_LINEAR plans of the axes
+    const ResamplePlan* planY;
+    const float* weightsX;          // Weights of planX in floats
+    ResampleControl* control;       // Progress and cancellation, may be 0
+};
+
+// The output rows r0 <= r < r1 of the region
+static void bilinearRows(const BilinearPass& pass, int r0, int r1) {
+    int srcX0 = pass.srcX0;
+    int srcX1 = pass.srcX1;
+    const int* tapsX = pass.planX->taps.data();
+    const float* weightsX = pass.weightsX;
+    const int* tapsY = pass.planY->taps.data();
+    const double* weightsY = pass.planY->weights.data();
+    std::vector<float> blended(srcX1 - srcX0);
+    float* b = blended.data() - srcX0;  // Indexed by the source columns
+    for (int r = r0; r < r1; ++r) {
+        if (isCancelled(pass.control))
+            return;
+        int c = r/pass.regionHeight;
+        int y = pass.y0 + r%pass.regionHeight;
+        const float* s0 = pass.src->row(c, tapsY[2*y]);
+        const float* s1 = pass.src->row(c, tapsY[2*y + 1]);
+        float w0 = (float) weightsY[2*y];
+        float w1 = (float) weightsY[2*y + 1];
+        for (int i = srcX0; i < srcX1; ++i)
+            b[i] = w0*s0[i] + w1*s1[i];
+
+        float* dst = pass.dst->row(c, y - pass.y0) - pass.x0;
+        int x1 = pass.x0 + pass.regionWidth;
+        for (int x = pass.x0; x < x1; ++x) {
+            const int* t = tapsX + 2*x;
+            const float* w = weightsX + 2*x;
+            dst[x] = w[0]*b[t[0]] + w[1]*b[t[1]];
+        }
+        addRowsDone(pass.control, 1);
+    }
+}
+
+void bilinearInterpolation(
+    const PlanarImage& image,
+    int zoomedWidth, int zoomedHeight,
+    PlanarImage& zoomed,
+    double stepX, double stepY,
+    int numThreads, /* = 0 */
+    ResampleControl* control    /* = 0 */
+) {
+    bilinearRegion(
+        ImageWindow(image), zoomedWidth, zoomedHeight,
+        0, 0, zoomedWidth, zoomedHeight, zoomed,
+        stepX, stepY, numThreads, control
+    );
+}
+
+void bilinearRegion(
+    const ImageWindow& image,
+    int zoomedWidth, int zoomedHeight,
+    int x0, int y0, int regionWidth, int regionHeight,
+    PlanarImage& region,
+    double stepX, double stepY,
+    int numThreads, /* = 0 */
+    ResampleControl* control    /* = 0 */
+) {
+    assert(&region != image.part);
+    assert(
+        0 <= x0 && x0 + regionWidth <= zoomedWidth &&
+        0 <= y0 && y0 + regionHeight <= zoomedHeight
+    );
+    int imageWidth = image.width;
+    int imageHeight = image.height;
+    if (
+        imageWidth <= 0 || imageHeight <= 0 ||
+        regionWidth <= 0 || regionHeight <= 0
+    )
+        return;
+    region.create(regionWidth, regionHeight);
+
+    std::shared_ptr<const ResamplePlan> planX = ResamplePlan::get(
+        KERNEL_LINEAR, imageWidth, zoomedWidth, stepX
+    );
+    std::shared_ptr<const ResamplePlan> planY = ResamplePlan::get(
+        KERNEL_LINEAR, imageHeight, zoomedHeight, stepY
+    );
+    std::vector<float> weightsX(planX->weights.size());
+    for (size_t i = 0; i < weightsX.size(); ++i)
+        weightsX[i] = (float) planX->weights[i];
+
+    BilinearPass pass;
+    pass.src = &image;
+    pass.x0 = x0;
+    pass.y0 = y0;
+    pass.regionWidth = regionWidth;
+    pass.regionHeight = regionHeight;
+    // The taps grow with the output column
+    pass.srcX0 = planX->taps[2*x0];
+    pass.srcX1 = planX->taps[2*(x0 + regionWidth - 1) + 1] + 1;
+    assert(
+        image.contains(
+            pass.srcX0, planY->taps[2*y0], pass.srcX1 - pass.srcX0,
+            planY->taps[2*(y0 + regionHeight - 1) + 1] + 1 -
+            planY->taps[2*y0]
+        )
+    );
+    pass.dst = &region;
+    pass.planX = planX.get();
+    pass.planY = planY.get();
+    pass.weightsX = weightsX.data();
+    pass.control = control;
+
+    int n = NUM_PLANES*regionHeight;
+    addRowsTotal(control, n);
+    runThreadRanges(bilinearRows, pass, 0, n, numThreads);
+}
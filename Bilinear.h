@@ -0,0 +1,40 @@
+#ifndef BILINEAR_H
+#define BILINEAR_H
+
+#include "PlanarImage.h"
+
+class ResampleControl;
+
+// Bilinear interpolation of the planar image.
+// The output pixel (x, y) is taken at the source position
+// (x*stepX, y*stepY), the neighbours outside the image are clamped
+// to the border (see KERNEL_LINEAR of ResamplePlan). For every output
+// row the 2 source rows are blended first, then the blended row
+// is interpolated horizontally with the taps computed once for all rows.
+// The planes are processed independently; zoomed is (re)allocated
+// with the size zoomedWidth x zoomedHeight
+void bilinearInterpolation(
+    const PlanarImage& image,
+    int zoomedWidth, int zoomedHeight,
+    PlanarImage& zoomed,
+    double stepX, double stepY,     // Source pixels per output pixel
+    int numThreads = 0,             // 0 -- use all processors
+    ResampleControl* control = 0    // Progress and cancellation
+);
+
+// The part x0 <= x < x0 + regionWidth, y0 <= y < y0 + regionHeight
+// of the result of bilinearInterpolation of the whole image with
+// the same parameters, the pixels are the same as in the whole result;
+// region is (re)allocated with the size regionWidth x regionHeight.
+// Only the source pixels of the taps of the region are read
+void bilinearRegion(
+    const ImageWindow& image,
+    int zoomedWidth, int zoomedHeight,
+    int x0, int y0, int regionWidth, int regionHeight,
+    PlanarImage& region,
+    double stepX, double stepY,
+    int numThreads = 0,
+    ResampleControl* control = 0
+);
+
+#endif
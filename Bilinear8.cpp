@@ -0,0 +1,329 @@
+#include <cassert>
+#include <vector>
+#if defined(__SSE2__)
+#   include <emmintrin.h>
+#endif
+// The AVX2 kernel is compiled whatever the target of the build
+// and chosen at run time; the builds without SSE2 are scalar
+#if defined(__SSE2__) && defined(__GNUC__)
+#   include <immintrin.h>
+#   define BILINEAR8_AVX2
+#endif
+#include "Bilinear8.h"
+#include "RealPixel.h"
+#include "ResamplePlan.h"
+#include "ResampleControl.h"
+
+// Fixed point: the weights have 14 fraction bits (w0 + w1 == 1 << 14),
+// the intermediate values of the rows pass have 7 fraction bits,
+// so they fit into signed 16-bit numbers (255 << 7 < 32768)
+const int BILINEAR8_WEIGHT_BITS = 14;
+const int BILINEAR8_ROW_SHIFT = BILINEAR8_WEIGHT_BITS - 7;
+const int BILINEAR8_COLUMN_SHIFT = BILINEAR8_WEIGHT_BITS + 7;
+
+// The region x0 <= x < x0 + regionWidth, y0 <= y < y0 + regionHeight
+// of the result is computed from the source columns srcX0 <= i <
+// srcX0 + width; src points to the column srcX0 of the source row srcY0
+struct Bilinear8Pass {
+    int width;
+    const unsigned char* src;
+    int srcBytesPerLine;
+    int srcY0;
+    int y0;
+    int regionWidth;
+    unsigned char* dst;
+    int dstBytesPerLine;
+
+    const int* rows;        // 2 source rows per output row
+    const int* columns;     // Source column (from srcX0) per output
+                            // column of the region
+    // Weights (w0, w1) packed into 32-bit numbers: w0 | (w1 << 16)
+    const int* rowWeights;
+    const int* columnWeights;
+    int integerZoom;        // 2, 3 or 4 if the columns have the fixed
+                            // phases of this zoom, otherwise 0
+    ResampleControl* control;   // Progress and cancellation, may be 0
+};
+
+static inline int packWeights(double f) {
+    int w1 = (int)(f*(double)(1 << BILINEAR8_WEIGHT_BITS) + 0.5);
+    int w0 = (1 << BILINEAR8_WEIGHT_BITS) - w1;
+    return w0 | (w1 << 16);
+}
+
+// Packed weights of the phase k of the integer zoom z
+static constexpr int zoomWeights(int k, int z) {
+    return ((1 << BILINEAR8_WEIGHT_BITS) -
+        ((2*k << BILINEAR8_WEIGHT_BITS) + z)/(2*z)) |
+        ((((2*k << BILINEAR8_WEIGHT_BITS) + z)/(2*z)) << 16);
+}
+
+#if defined(BILINEAR8_AVX2)
+static bool hasAvx2() {
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    return avx2;
+}
+
+// The part of blendRows by 16 bytes, returns the number of bytes done
+__attribute__((target("avx2")))
+static int blendRowsAvx2(
+    const unsigned char* r0, const unsigned char* r1, int weights,
+    short* tmp, int n
+) {
+    int i = 0;
+    const int round = 1 << (BILINEAR8_ROW_SHIFT - 1);
+    __m256i w = _mm256_set1_epi32(weights);
+    __m256i r = _mm256_set1_epi32(round);
+    for (; i + 16 <= n; i += 16) {
+        __m256i a = _mm256_cvtepu8_epi16(
+            _mm_loadu_si128((const __m128i*)(r0 + i))
+        );
+        __m256i b = _mm256_cvtepu8_epi16(
+            _mm_loadu_si128((const __m128i*)(r1 + i))
+        );
+        __m256i lo = _mm256_madd_epi16(_mm256_unpacklo_epi16(a, b), w);
+        __m256i hi = _mm256_madd_epi16(_mm256_unpackhi_epi16(a, b), w);
+        lo = _mm256_srai_epi32(_mm256_add_epi32(lo, r), BILINEAR8_ROW_SHIFT);
+        hi = _mm256_srai_epi32(_mm256_add_epi32(hi, r), BILINEAR8_ROW_SHIFT);
+        // unpack and pack work in 128-bit lanes, so the order is kept
+        _mm256_storeu_si256(
+            (__m256i*)(tmp + i), _mm256_packs_epi32(lo, hi)
+        );
+    }
+    return i;
+}
+#endif
+
+// Blend the bytes of two source rows: n bytes
+static void blendRows(
+    const unsigned char* r0, const unsigned char* r1, int weights,
+    short* tmp, int n
+) {
+    int i = 0;
+    const int round = 1 << (BILINEAR8_ROW_SHIFT - 1);
+#if defined(BILINEAR8_AVX2)
+    if (hasAvx2())
+        i = blendRowsAvx2(r0, r1, weights, tmp, n);
+#endif
+#if defined(__SSE2__)
+    __m128i w = _mm_set1_epi32(weights);
+    __m128i r = _mm_set1_epi32(round);
+    __m128i zero = _mm_setzero_si128();
+    for (; i + 8 <= n; i += 8) {
+        __m128i a = _mm_unpacklo_epi8(
+            _mm_loadl_epi64((const __m128i*)(r0 + i)), zero
+        );
+        __m128i b = _mm_unpacklo_epi8(
+            _mm_loadl_epi64((const __m128i*)(r1 + i)), zero
+        );
+        __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi16(a, b), w);
+        __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi16(a, b), w);
+        lo = _mm_srai_epi32(_mm_add_epi32(lo, r), BILINEAR8_ROW_SHIFT);
+        hi = _mm_srai_epi32(_mm_add_epi32(hi, r), BILINEAR8_ROW_SHIFT);
+        _mm_storeu_si128((__m128i*)(tmp + i), _mm_packs_epi32(lo, hi));
+    }
+#endif
+    int w0 = weights & 0xFFFF;
+    int w1 = weights >> 16;
+    for (; i < n; ++i)
+        tmp[i] = (short)((r0[i]*w0 + r1[i]*w1 + round) >> BILINEAR8_ROW_SHIFT);
+}
+
+// Blend the pairs of adjacent pixels of the intermediate row
+static void blendColumns(
+    const short* tmp, const int* columns, const int* weights,
+    unsigned char* dst, int zoomedWidth
+) {
+    const int round = 1 << (BILINEAR8_COLUMN_SHIFT - 1);
+#if defined(__SSE2__)
+    __m128i r = _mm_set1_epi32(round);
+    for (int x = 0; x < zoomedWidth; ++x) {
+        // 2 pixels: p0 c0..c3, p1 c0..c3 -> p0 c0, p1 c0, p0 c1, p1 c1, ...
+        __m128i v = _mm_loadu_si128((const __m128i*)(tmp + 4*columns[x]));
+        v = _mm_unpacklo_epi16(v, _mm_srli_si128(v, 8));
+        v = _mm_madd_epi16(v, _mm_set1_epi32(weights[x]));
+        v = _mm_srai_epi32(_mm_add_epi32(v, r), BILINEAR8_COLUMN_SHIFT);
+        v = _mm_packs_epi32(v, v);
+        v = _mm_packus_epi16(v, v);
+        *((int*)(dst + 4*x)) = _mm_cvtsi128_si32(v);
+    }
+#else
+    for (int x = 0; x < zoomedWidth; ++x) {
+        const short* p = tmp + 4*columns[x];
+        int w0 = weights[x] & 0xFFFF;
+        int w1 = weights[x] >> 16;
+        for (int c = 0; c < 4; ++c) {
+            int v = (p[c]*w0 + p[4 + c]*w1 + round) >> BILINEAR8_COLUMN_SHIFT;
+            dst[4*x + c] = (unsigned char)((v > 255)? 255 : v);
+        }
+    }
+#endif
+}
+
+// Blend the columns for the integer zoom Z: the source pixel i and its
+// right neighbour give the outputs i*Z .. i*Z + Z-1, the weights
+// are constants of the unrolled loop over the phases
+template <int Z>
+static void blendColumnsZoom(
+    const short* tmp, int width, unsigned char* dst
+) {
+    const int round = 1 << (BILINEAR8_COLUMN_SHIFT - 1);
+#if defined(__SSE2__)
+    __m128i r = _mm_set1_epi32(round);
+    __m128i w[Z];
+    for (int k = 0; k < Z; ++k)
+        w[k] = _mm_set1_epi32(zoomWeights(k, Z));
+    for (int i = 0; i < width; ++i) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(tmp + 4*i));
+        v = _mm_unpacklo_epi16(v, _mm_srli_si128(v, 8));
+        for (int k = 0; k < Z; ++k) {
+            __m128i p = _mm_madd_epi16(v, w[k]);
+            p = _mm_srai_epi32(_mm_add_epi32(p, r), BILINEAR8_COLUMN_SHIFT);
+            p = _mm_packs_epi32(p, p);
+            p = _mm_packus_epi16(p, p);
+            *((int*)(dst + 4*(Z*i + k))) = _mm_cvtsi128_si32(p);
+        }
+    }
+#else
+    for (int i = 0; i < width; ++i) {
+        const short* p = tmp + 4*i;
+        for (int k = 0; k < Z; ++k) {
+            const int w0 = zoomWeights(k, Z) & 0xFFFF;
+            const int w1 = zoomWeights(k, Z) >> 16;
+            unsigned char* q = dst + 4*(Z*i + k);
+            for (int c = 0; c < 4; ++c) {
+                int v = (p[c]*w0 + p[4 + c]*w1 + round) >>
+                    BILINEAR8_COLUMN_SHIFT;
+                q[c] = (unsigned char)((v > 255)? 255 : v);
+            }
+        }
+    }
+#endif
+}
+
+// The output rows y0 <= y < y1 of the region
+static void bilinear8Rows(const Bilinear8Pass& pass, int y0, int y1) {
+    // The last pixel is repeated, so the right neighbour of every
+    // source column exists
+    int n = 4*pass.width;
+    std::vector<short> tmp(n + 4 + 8);
+    for (int y = y0; y < y1; ++y) {
+        if (isCancelled(pass.control))
+            return;
+        const unsigned char* r0 = pass.src +
+            (ptrdiff_t)(pass.rows[2*y] - pass.srcY0)*pass.srcBytesPerLine;
+        const unsigned char* r1 = pass.src +
+            (ptrdiff_t)(pass.rows[2*y + 1] - pass.srcY0)*
+            pass.srcBytesPerLine;
+        blendRows(r0, r1, pass.rowWeights[y], tmp.data(), n);
+        for (int c = 0; c < 4; ++c)
+            tmp[n + c] = tmp[n - 4 + c];
+        unsigned char* dst =
+            pass.dst + (ptrdiff_t)(y - pass.y0)*pass.dstBytesPerLine;
+        if (pass.integerZoom == 2)
+            blendColumnsZoom<2>(tmp.data(), pass.width, dst);
+        else if (pass.integerZoom == 3)
+            blendColumnsZoom<3>(tmp.data(), pass.width, dst);
+        else if (pass.integerZoom == 4)
+            blendColumnsZoom<4>(tmp.data(), pass.width, dst);
+        else
+            blendColumns(
+                tmp.data(), pass.columns, pass.columnWeights,
+                dst, pass.regionWidth
+            );
+        addRowsDone(pass.control, 1);
+    }
+}
+
+void bilinearInterpolation8(
+    int imageWidth, int imageHeight,
+    const unsigned char* imageBits, int imageBytesPerLine,
+    int zoomedWidth, int zoomedHeight,
+    unsigned char* zoomedBits, int zoomedBytesPerLine,
+    double stepX, double stepY,
+    int numThreads, /* = 0 */
+    ResampleControl* control    /* = 0 */
+) {
+    bilinearRegion8(
+        imageWidth, imageHeight, imageBits, imageBytesPerLine, 0, 0,
+        zoomedWidth, zoomedHeight, 0, 0, zoomedWidth, zoomedHeight,
+        zoomedBits, zoomedBytesPerLine,
+        stepX, stepY, numThreads, control
+    );
+}
+
+void bilinearRegion8(
+    int imageWidth, int imageHeight,
+    const unsigned char* bits, int bytesPerLine, int bitsX0, int bitsY0,
+    int zoomedWidth, int zoomedHeight,
+    int x0, int y0, int regionWidth, int regionHeight,
+    unsigned char* regionBits, int regionBytesPerLine,
+    double stepX, double stepY,
+    int numThreads, /* = 0 */
+    ResampleControl* control    /* = 0 */
+) {
+    assert(
+        0 <= x0 && x0 + regionWidth <= zoomedWidth &&
+        0 <= y0 && y0 + regionHeight <= zoomedHeight
+    );
+    if (
+        imageWidth <= 0 || imageHeight <= 0 ||
+        regionWidth <= 0 || regionHeight <= 0
+    )
+        return;
+
+    // Source indices clamped at the edges
+    std::shared_ptr<const ResamplePlan> planX = ResamplePlan::get(
+        KERNEL_LINEAR, imageWidth, zoomedWidth, stepX
+    );
+    std::shared_ptr<const ResamplePlan> planY = ResamplePlan::get(
+        KERNEL_LINEAR, imageHeight, zoomedHeight, stepY
+    );
+    // The source columns of the region: from the left tap of the first
+    // output column to the right neighbour of the last left tap
+    int x1 = x0 + regionWidth;
+    int srcX0 = planX->taps[2*x0];
+    int srcX1 = planX->taps[2*(x1 - 1)] + 2;
+    if (srcX1 > imageWidth)
+        srcX1 = imageWidth;
+    assert(srcX0 >= bitsX0 && planY->taps[2*y0] >= bitsY0);
+    std::vector<int> columns(regionWidth);
+    std::vector<int> columnWeights(regionWidth);
+    for (int x = x0; x < x1; ++x) {
+        columns[x - x0] = planX->taps[2*x] - srcX0;
+        columnWeights[x - x0] = packWeights(planX->weights[2*x + 1]);
+    }
+    std::vector<int> rowWeights(zoomedHeight);
+    for (int y = y0; y < y0 + regionHeight; ++y)
+        rowWeights[y] = packWeights(planY->weights[2*y + 1]);
+
+    Bilinear8Pass pass;
+    pass.width = srcX1 - srcX0;
+    pass.src = bits + 4*(ptrdiff_t)(srcX0 - bitsX0);
+    pass.srcBytesPerLine = bytesPerLine;
+    pass.srcY0 = bitsY0;
+    pass.y0 = y0;
+    pass.regionWidth = regionWidth;
+    pass.dst = regionBits;
+    pass.dstBytesPerLine = regionBytesPerLine;
+    pass.rows = planY->taps.data();
+    pass.columns = columns.data();
+    pass.rowWeights = rowWeights.data();
+    pass.columnWeights = columnWeights.data();
+    pass.integerZoom = 0;
+    pass.control = control;
+    // The phases of the integer zoom start at the first column,
+    // so only the whole rows of the result have them
+    for (int z = 2; z <= 4; ++z) {
+        if (
+            zoomedWidth == z*imageWidth && stepX == 1./(double) z &&
+            x0 == 0 && regionWidth == zoomedWidth
+        )
+            pass.integerZoom = z;
+    }
+
+    // The output rows are divided into contiguous ranges
+    int y1 = y0 + regionHeight;
+    addRowsTotal(control, regionHeight);
+    runThreadRanges(bilinear8Rows, pass, y0, y1, numThreads);
+}
@@ -0,0 +1,47 @@
+#ifndef BILINEAR8_H
+#define BILINEAR8_H
+
+class ResampleControl;
+
+// Bilinear interpolation of 8-bit images with 4 channels per pixel
+// (32-bit pixels: QImage::Format_RGB32, Format_ARGB32, ...), all
+// channels are processed in the same way. The rows of the images are
+// given by the pointer to the first row and the distance between rows
+// in bytes, so the scanlines of QImage are used directly:
+//     bilinearInterpolation8(
+//         src.width(), src.height(), src.constBits(), src.bytesPerLine(),
+//         dst.width(), dst.height(), dst.bits(), dst.bytesPerLine(), ...
+//     );
+// The output pixel (x, y) is taken at the source position
+// (x*stepX, y*stepY), the neighbours outside the image are clamped
+// to the border. The weights are fixed-point numbers with 14 fraction
+// bits; the rows are blended first into 16-bit intermediate values
+// (SSE2, and AVX2 on the processors that have it), then the columns.
+void bilinearInterpolation8(
+    int imageWidth, int imageHeight,
+    const unsigned char* imageBits, int imageBytesPerLine,
+    int zoomedWidth, int zoomedHeight,
+    unsigned char* zoomedBits, int zoomedBytesPerLine,
+    double stepX, double stepY,     // Source pixels per output pixel
+    int numThreads = 0,             // 0 -- use all processors
+    ResampleControl* control = 0    // Progress and cancellation
+);
+
+// The part x0 <= x < x0 + regionWidth, y0 <= y < y0 + regionHeight
+// of the result of bilinearInterpolation8 with the same parameters,
+// the pixels are the same as in the whole result. bits points to
+// the source pixel (bitsX0, bitsY0): the rows need to hold only
+// the source pixels of the taps of the region. regionBits receives
+// regionWidth x regionHeight pixels
+void bilinearRegion8(
+    int imageWidth, int imageHeight,
+    const unsigned char* bits, int bytesPerLine, int bitsX0, int bitsY0,
+    int zoomedWidth, int zoomedHeight,
+    int x0, int y0, int regionWidth, int regionHeight,
+    unsigned char* regionBits, int regionBytesPerLine,
+    double stepX, double stepY,
+    int numThreads = 0,
+    ResampleControl* control = 0
+);
+
+#endif
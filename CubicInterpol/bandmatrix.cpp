@@ -5,6 +5,7 @@
 static const double EPS = 1e-8;
 
 bool BandExtMatrix::gauss() {
+    factorized = false;
     int i = 0;
     while (i < n) {
         double maxelem = fabs(at(i, i));
@@ -97,6 +98,83 @@ bool BandExtMatrix::solve(
     return true;
 }
 
+bool BandExtMatrix::factorize() {
+    factorized = false;
+    for (int i = 0; i < n; ++i) {
+        double maxelem = fabs(at(i, i));
+        int maxidx = i;
+        int im = i + d0;
+        if (im > n - 1)
+            im = n - 1;
+        for (int k = i+1; k <= im; ++k) {
+            if (fabs(at(k, i)) > maxelem) {
+                maxelem = fabs(at(k, i));
+                maxidx = k;
+            }
+        }
+        if (maxelem <= EPS)
+            return false;       // Zero determinant
+        pivots[i] = maxidx;
+
+        int jm = i + d0 + d1 - 1;
+        if (jm > n - 1)
+            jm = n - 1;
+        if (maxidx != i) {
+            // The same row swapping as in gauss(). The multipliers
+            // of previous steps (columns < i) stay in their places
+            for (int j = i; j <= jm; ++j) {
+                double tmp = at(i, j);
+                at(i, j) = at(maxidx, j);
+                at(maxidx, j) = (-tmp);
+            }
+        }
+        double z = at(i, i);
+        assert(fabs(z) > EPS);
+        for (int k = i+1; k <= im; ++k) {
+            double c = (-at(k, i) / z);
+            at(k, i) = c;       // Keep the multiplier
+            for (int j = i+1; j <= jm; ++j) {
+                at(k, j) += at(i, j)*c;
+            }
+        }
+    }
+    factorized = (fabs(at(n-1, n-1)) > EPS);
+    return factorized;
+}
+
+void BandExtMatrix::solveFactorized(double* p) const {
+    assert(factorized);
+
+    // Repeat the row operations of factorize() on the free terms
+    for (int i = 0; i < n; ++i) {
+        int m = pivots[i];
+        if (m != i) {
+            double tmp = p[i];
+            p[i] = p[m];
+            p[m] = (-tmp);
+        }
+        int im = i + d0;
+        if (im > n - 1)
+            im = n - 1;
+        double v = p[i];
+        for (int k = i+1; k <= im; ++k) {
+            p[k] += v * at(k, i);
+        }
+    }
+
+    // Back substitution
+    for (int i = n-1; i >= 0; --i) {
+        int jm = i+d0+d1-1;
+        if (jm > n-1)
+            jm = n-1;
+        double s = p[i];
+        for (int j = i+1; j <= jm; ++j) {
+            s -= p[j]*at(i, j);
+        }
+        p[i] = s * (1./at(i, i));
+    }
+}
+
 void BandExtMatrix::multiply(const double* p, double* q) const {
     for (int i = 0; i < n; ++i) {
         q[i] = 0;
@@ -12,6 +12,12 @@
 // a space for d0 additional diagonal, total (i, i+d0+d1-1).
 // So the total space needed
 // (without the right column) equals n*(d0+d1).
+//
+// The matrix can also be factorized once (factorize()) and then
+// used to solve the system for any number of right-hand sides
+// (solveFactorized()). In this case the multipliers of elimination
+// are kept in the place of eliminated elements, and the row
+// permutation is kept in the pivots array.
 class BandExtMatrix {
 public:
     int n;              // Matrix size
@@ -22,6 +28,8 @@ public:
     int numDiags;       // d0 + d1
     double* elements;   //
     double* r;          // Free terms column
+    int* pivots;        // Row permutation of factorize()
+    bool factorized;    // Elements contain the LU-factorization
 private:
     BandExtMatrix();
 
@@ -32,13 +40,17 @@ public:
         d1(diags1),
         numDiags(2*d0 + d1),
         elements(new double[n*numDiags]),
-        r(new double[n])
+        r(new double[n]),
+        pivots(new int[n]),
+        factorized(false)
     {
         int k = n*numDiags;
         for (int i = 0; i < k; ++i)
             elements[i] = 0.;
-        for (int i = 0; i < n; ++i)
+        for (int i = 0; i < n; ++i) {
             r[i] = 0.;
+            pivots[i] = i;
+        }
     }
 
     BandExtMatrix(const BandExtMatrix& m):
@@ -47,13 +59,17 @@ public:
         d1(m.d1),
         numDiags(m.numDiags),
         elements(new double[n*numDiags]),
-        r(new double[n])
+        r(new double[n]),
+        pivots(new int[n]),
+        factorized(m.factorized)
     {
         int k = n*numDiags;
         for (int i = 0; i < k; ++i)
             elements[i] = m.elements[i];
-        for (int i = 0; i < n; ++i)
+        for (int i = 0; i < n; ++i) {
             r[i] = m.r[i];
+            pivots[i] = m.pivots[i];
+        }
     }
 
     BandExtMatrix& operator=(const BandExtMatrix& m) {
@@ -61,22 +77,29 @@ public:
         int k = n*numDiags;
         for (int i = 0; i < k; ++i)
             elements[i] = m.elements[i];
-        for (int i = 0; i < n; ++i)
+        for (int i = 0; i < n; ++i) {
             r[i] = m.r[i];
+            pivots[i] = m.pivots[i];
+        }
+        factorized = m.factorized;
         return *this;
     }
 
     ~BandExtMatrix() {
         delete[] elements;
         delete[] r;
+        delete[] pivots;
     }
 
     void init() {
         int k = n*numDiags;
         for (int i = 0; i < k; ++i)
             elements[i] = 0.;
-        for (int i = 0; i < n; ++i)
+        for (int i = 0; i < n; ++i) {
             r[i] = 0.;
+            pivots[i] = i;
+        }
+        factorized = false;
     }
 
     int numElems() const {
@@ -97,6 +120,8 @@ public:
         if (s > n) {
             delete[] r;
             r = new double[s];
+            delete[] pivots;
+            pivots = new int[s];
         }
         n = s;
         d0 = diags0;
@@ -137,6 +162,17 @@ public:
         double* p
     );
 
+    // Gauss eliminating that keeps the multipliers and
+    // the row permutation, so that the system can be solved
+    // later for any number of right-hand sides.
+    // The free terms column r is not used.
+    bool factorize(); // Returns (det() != 0)
+
+    // Solve the system using the factorization computed by factorize().
+    // On input p contains the free terms column,
+    // on output it contains the solution
+    void solveFactorized(double* p) const;
+
     void multiply(const double* p, double* q) const;
 
     void print() const;
@@ -0,0 +1,81 @@
+#include <cassert>
+#include <cmath>
+#include "bspline.h"
+
+// Initial value of the causal filter:
+//     c[0] = sum_k z^k * s[k]
+// over the mirror extended samples.
+// If the sum converges faster than the length of data,
+// it is truncated, otherwise computed exactly
+static void initialCausal(
+    double* data, int n, int step, int numLanes, double* sum
+) {
+    const double z = BSPLINE_POLE;
+    int horizon = (int) ceil(log(BSPLINE_TOLERANCE) / log(fabs(z)));
+    for (int lane = 0; lane < numLanes; ++lane)
+        sum[lane] = data[lane];
+
+    if (horizon < n) {
+        double zn = z;
+        for (int k = 1; k < horizon; ++k) {
+            const double* s = data + k*step;
+            for (int lane = 0; lane < numLanes; ++lane)
+                sum[lane] += zn*s[lane];
+            zn *= z;
+        }
+    } else {
+        double zn = z;
+        double iz = 1./z;
+        double z2n = pow(z, (double)(n - 1));
+        const double* last = data + (n - 1)*step;
+        for (int lane = 0; lane < numLanes; ++lane)
+            sum[lane] += z2n*last[lane];
+        z2n *= z2n*iz;
+        for (int k = 1; k < n - 1; ++k) {
+            const double* s = data + k*step;
+            for (int lane = 0; lane < numLanes; ++lane)
+                sum[lane] += (zn + z2n)*s[lane];
+            zn *= z;
+            z2n *= iz;
+        }
+        double norm = 1./(1. - zn*zn);
+        for (int lane = 0; lane < numLanes; ++lane)
+            sum[lane] *= norm;
+    }
+}
+
+void bsplinePrefilter(double* data, int n, int step, int numLanes) {
+    if (n <= 1)
+        return;
+    const double z = BSPLINE_POLE;
+    const double lambda = (1. - z)*(1. - 1./z);     // == 6
+
+    assert(numLanes <= step);
+    for (int k = 0; k < n; ++k) {
+        double* s = data + k*step;
+        for (int lane = 0; lane < numLanes; ++lane)
+            s[lane] *= lambda;
+    }
+
+    // Causal pass. The initial value replaces the first sample
+    initialCausal(data, n, step, numLanes, data);
+    for (int k = 1; k < n; ++k) {
+        double* c = data + k*step;
+        const double* prev = c - step;
+        for (int lane = 0; lane < numLanes; ++lane)
+            c[lane] += z*prev[lane];
+    }
+
+    // Anti-causal pass
+    double* last = data + (n - 1)*step;
+    const double* beforeLast = last - step;
+    const double a = z/(z*z - 1.);
+    for (int lane = 0; lane < numLanes; ++lane)
+        last[lane] = a*(z*beforeLast[lane] + last[lane]);
+    for (int k = n - 2; k >= 0; --k) {
+        double* c = data + k*step;
+        const double* next = c + step;
+        for (int lane = 0; lane < numLanes; ++lane)
+            c[lane] = z*(next[lane] - c[lane]);
+    }
+}
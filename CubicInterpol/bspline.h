@@ -0,0 +1,53 @@
+#ifndef BSPLINE_H
+#define BSPLINE_H
+
+// Cardinal cubic B-spline on a uniform grid.
+//
+// The interpolating spline is represented as
+//     f(t) = sum_k c[k]*beta3(t - k),
+// where beta3 is the cubic B-spline. The coefficients c[k] are obtained
+// from the samples s[k] by the recursive (IIR) prefilter: one causal
+// and one anti-causal pass of the first order filter with the pole
+//     z = sqrt(3) - 2.
+// The samples are extended by mirror symmetry at both ends:
+//     s[-k] = s[k], s[n-1+k] = s[n-1-k].
+// No linear system is solved, the prefilter takes O(n) operations.
+
+const double BSPLINE_POLE = (-0.26794919243112270647);    // sqrt(3) - 2
+const double BSPLINE_TOLERANCE = 1e-12;     // Precision of initialization
+
+// Prefilter the samples in place.
+// The samples are data[i*step + lane], i = 0..n-1, lane = 0..numLanes-1,
+// all lanes are filtered simultaneously. So
+//     a row of pixels with 3 channels: step = 3, numLanes = 3;
+//     the columns of an image with rows of length w: step = w, numLanes = w
+// (in the second case the inner loops go along the rows
+// and are easily vectorized).
+void bsplinePrefilter(double* data, int n, int step, int numLanes);
+
+// Weights of coefficients c[k-1], c[k], c[k+1], c[k+2]
+// for the point t = k + f, 0 <= f < 1
+inline void bsplineWeights(double f, double w[4]) {
+    double g = 1. - f;
+    double f2 = f*f;
+    double g2 = g*g;
+    w[0] = g2*g/6.;
+    w[1] = 2./3. - f2 + 0.5*f2*f;
+    w[2] = 2./3. - g2 + 0.5*g2*g;
+    w[3] = f2*f/6.;
+}
+
+// Index of coefficient with the mirror extension on the interval [0, n-1]
+inline int bsplineMirror(int k, int n) {
+    if (n <= 1)
+        return 0;
+    int period = 2*(n - 1);
+    if (k < 0)
+        k = (-k);
+    k %= period;
+    if (k >= n)
+        k = period - k;
+    return k;
+}
+
+#endif
@@ -3,99 +3,6 @@
 #include "cubint.h"
 #include "bandmatrix.h"
 
-// Interpolate so that
-//     p(a) = value0, dp(a) = derivative0
-//     p(b) = value0, dp(b) = derivative1
-//
-CubicPolynomial& CubicPolynomial::interpolate(
-    double a, double b,
-    double va, double da,
-    double vb, double db
-) {
-    double a2 = a*a; double a3 = a2*a;
-    double b2 = b*b; // double b3 = b2*b;
-    double a_b = a - b;
-    double a_b2 = a_b*a_b;
-    double a_b3 = a_b2*a_b;
-    // coeff[0] =
-    // -a^3*b*da/(a^3 - 3*a^2*b + 3*a*b^2 - b^3)
-    // + a^2*b^2*da/(a^3 - 3*a^2*b + 3*a*b^2 - b^3)
-    // - a^3*b*db/(a^3 - 3*a^2*b + 3*a*b^2 - b^3)
-    // + a^2*b^2*db/(a^3 - 3*a^2*b + 3*a*b^2 - b^3)
-    // + a^2*b*da/(a^2 - 2*a*b + b^2)
-    // - a*b^2*da/(a^2 - 2*a*b + b^2)
-    // + 2*a^2*b*va/(a^3 - 3*a^2*b + 3*a*b^2 - b^3)
-    // - 2*a^2*b*vb/(a^3 - 3*a^2*b + 3*a*b^2 - b^3)
-    // - a*b*va/(a^2 - 2*a*b + b^2)
-    // + a*b*vb/(a^2 - 2*a*b + b^2)
-    // - a*va/(a - b)
-    // + va
-    // + a*vb/(a - b)
-    coeff[0] =
-        (-a3*b*da + a2*b2*da - a3*b*db+ a2*b2*db
-            + 2*a2*b*va- 2*a2*b*vb)/a_b3 +
-        (a2*b*da - a*b2*da - a*b*va + a*b*vb)/a_b2 +
-        (-a*va + a*vb)/a_b +
-        va;
-
-    // coeff[1] =
-    // a^3*da/(a^3 - 3*a^2*b + 3*a*b^2 - b^3)
-    // + a^2*b*da/(a^3 - 3*a^2*b + 3*a*b^2 - b^3)
-    // - 2*a*b^2*da/(a^3 - 3*a^2*b + 3*a*b^2 - b^3)
-    // + a^3*db/(a^3 - 3*a^2*b + 3*a*b^2 - b^3)
-    // + a^2*b*db/(a^3 - 3*a^2*b + 3*a*b^2 - b^3)
-    // - 2*a*b^2*db/(a^3 - 3*a^2*b + 3*a*b^2 - b^3)
-    // - a^2*da/(a^2 - 2*a*b + b^2)
-    // + b^2*da/(a^2 - 2*a*b + b^2)
-    // - 2*a^2*va/(a^3 - 3*a^2*b + 3*a*b^2 - b^3)
-    // - 4*a*b*va/(a^3 - 3*a^2*b + 3*a*b^2 - b^3)
-    // + 2*a^2*vb/(a^3 - 3*a^2*b + 3*a*b^2 - b^3)
-    // + 4*a*b*vb/(a^3 - 3*a^2*b + 3*a*b^2 - b^3)
-    // + a*va/(a^2 - 2*a*b + b^2)
-    // + b*va/(a^2 - 2*a*b + b^2)
-    // - a*vb/(a^2 - 2*a*b + b^2)
-    // - b*vb/(a^2 - 2*a*b + b^2)
-    // + va/(a - b)
-    // - vb/(a - b)
-    coeff[1] =
-        (a3*da + a2*b*da - 2*a*b2*da + a3*db + a2*b*db - 2*a*b2*db
-            - 2*a2*va - 4*a*b*va + 2*a2*vb + 4*a*b*vb)/a_b3 +
-        (-a2*da + b2*da + a*va + b*va - a*vb - b*vb)/a_b2 +
-        (va - vb)/a_b;
-
-    // coeff[2] =
-    // - 2*a^2*da/(a^3 - 3*a^2*b + 3*a*b^2 - b^3)
-    // + a*b*da/(a^3 - 3*a^2*b + 3*a*b^2 - b^3)
-    // + b^2*da/(a^3 - 3*a^2*b + 3*a*b^2 - b^3)
-    // - 2*a^2*db/(a^3 - 3*a^2*b + 3*a*b^2 - b^3)
-    // + a*b*db/(a^3 - 3*a^2*b + 3*a*b^2 - b^3)
-    // + b^2*db/(a^3 - 3*a^2*b + 3*a*b^2 - b^3)
-    // + a*da/(a^2 - 2*a*b + b^2)
-    // - b*da/(a^2 - 2*a*b + b^2)
-    // + 4*a*va/(a^3 - 3*a^2*b + 3*a*b^2 - b^3)
-    // + 2*b*va/(a^3 - 3*a^2*b + 3*a*b^2 - b^3)
-    // - 4*a*vb/(a^3 - 3*a^2*b + 3*a*b^2 - b^3)
-    // - 2*b*vb/(a^3 - 3*a^2*b + 3*a*b^2 - b^3)
-    // - va/(a^2 - 2*a*b + b^2)
-    // + vb/(a^2 - 2*a*b + b^2)
-    coeff[2] =
-        (-2*a2*da + a*b*da + b2*da - 2*a2*db + a*b*db + b2*db
-            + 4*a*va + 2*b*va - 4*a*vb - 2*b*vb)/a_b3 +
-        (a*da - b*da - va + vb)/a_b2;
-
-    // coeff[3] =
-    // + a*da/(a^3 - 3*a^2*b + 3*a*b^2 - b^3)
-    // - b*da/(a^3 - 3*a^2*b + 3*a*b^2 - b^3)
-    // + a*db/(a^3 - 3*a^2*b + 3*a*b^2 - b^3)
-    // - b*db/(a^3 - 3*a^2*b + 3*a*b^2 - b^3)
-    // - 2*va/(a^3 - 3*a^2*b + 3*a*b^2 - b^3)
-    // + 2*vb/(a^3 - 3*a^2*b + 3*a*b^2 - b^3)
-    coeff[3] =
-        // (a*da - b*da + a*db - b*db - 2*va + 2*vb)/a_b3
-        (a_b*(da + db) - 2*(va - vb))/a_b3;
-    return *this;
-}
-
 int CubicSpline::findSegment(double x) const {  // Binary search
     assert(numNodes >= 2);
     if (numNodes < 2)
@@ -210,6 +117,9 @@ void CubicSpline::resize(int n) {
 
         delete bandMatrix; bandMatrix = 0;
         delete[] coeffs; coeffs = 0;
+        delete[] moments; moments = 0;
+        delete[] sweepC; sweepC = 0;
+        delete[] sweepW; sweepW = 0;
     } else {
         if (bandMatrix != 0)
             bandMatrix->resize((n - 1)*4, 5, 4);
@@ -217,117 +127,140 @@ void CubicSpline::resize(int n) {
     numNodes = n;
 }
 
-// Calculate cubic polynomials so the the spline will be C2-continues,
-// solving a system of linear equarions with band 9-diagonal matrix
-CubicSpline& CubicSpline::interpolateC2() {
-    if (numNodes <= 1)
-        return *this;
-
+// Fill in the matrix of linear system of C2-spline
+// and its free terms column. The unknowns of segment i are
+// the coefficients of its polynomial in the local coordinate
+// t = (x - x[i])/h[i], h[i] = x[i+1] - x[i]:
+//     f   = c0 + c1*t + c2*t^2 + c3*t^3
+//     f'  = (c1 + 2*c2*t + 3*c3*t^2)/h
+//     f'' = (2*c2 + 6*c3*t)/h^2
+// so the matrix does not depend on the magnitude of abscissas;
+// the rows of derivatives are multiplied by the powers of h[i-1]
+void CubicSpline::fillC2Matrix() {
+    assert(numNodes > 1);
     int n = (numNodes - 1)*4;
-    //... BandExtMatrix matr(n, 5, 4);
     if (bandMatrix == 0) {
         bandMatrix = new BandExtMatrix(n, 5, 4);
     }
-    if (coeffs == 0) {
-        coeffs = new double[n];
-    }
     bandMatrix->init();
 
-    // Fill in the matrix of linear system
     int i = 0, j0 = 0;
     int nodeIdx = 0;
-    double nodeX = nodes[nodeIdx].x;
-    double nodeX2 = nodeX*nodeX;
-    double nodeX3 = nodeX2*nodeX;
-    double nodeY = nodes[nodeIdx].y;
 
     // 1. First node: value == nodeY
     bandMatrix->at(i, 0) = 1.;
-    bandMatrix->at(i, 1) = nodeX;
-    bandMatrix->at(i, 2) = nodeX2;
-    bandMatrix->at(i, 3) = nodeX3;
-    bandMatrix->right(i) = nodeY;
+    bandMatrix->right(i) = nodes[0].y;
     ++i;
 
     // 2. First node: second derivative == 0
     bandMatrix->at(i, 2) = 2.;
-    bandMatrix->at(i, 3) = 6.*nodeX;
     ++i;
 
     ++nodeIdx;
-    nodeX = nodes[nodeIdx].x;
-    nodeX2 = nodeX*nodeX;
-    nodeX3 = nodeX2*nodeX;
-    nodeY = nodes[nodeIdx].y;
 
     // 2. Intermediate nodes
     while (nodeIdx < numNodes - 1) {
+        double nodeY = nodes[nodeIdx].y;
+        // Ratio of the lengths of the segments before and after the node
+        double ratio = (nodes[nodeIdx].x - nodes[nodeIdx - 1].x)/
+            (nodes[nodeIdx + 1].x - nodes[nodeIdx].x);
 
-        // 1. Value of (nodeIdx-1)-th curve in node nodeIdx
+        // 1. Value of (nodeIdx-1)-th curve in node nodeIdx (t == 1)
         j0 = nodeIdx*4;
         bandMatrix->at(i, (j0 - 4)) = 1.;
-        bandMatrix->at(i, (j0 - 4) + 1) = nodeX;
-        bandMatrix->at(i, (j0 - 4) + 2) = nodeX2;
-        bandMatrix->at(i, (j0 - 4) + 3) = nodeX3;
+        bandMatrix->at(i, (j0 - 4) + 1) = 1.;
+        bandMatrix->at(i, (j0 - 4) + 2) = 1.;
+        bandMatrix->at(i, (j0 - 4) + 3) = 1.;
         bandMatrix->right(i) = nodeY;
         ++i;
 
-        // 2. Value of nodeIdx-th curve in node nodeIdx
+        // 2. Value of nodeIdx-th curve in node nodeIdx (t == 0)
         bandMatrix->at(i, j0) = 1.;
-        bandMatrix->at(i, j0 + 1) = nodeX;
-        bandMatrix->at(i, j0 + 2) = nodeX2;
-        bandMatrix->at(i, j0 + 3) = nodeX3;
         bandMatrix->right(i) = nodeY;
         ++i;
 
         // 3. Values of derivatives of 2 adjacent curves in nodeIdx
         // are the same
-        // f   = c0 + c1*x + c2*x^2 + c3*x^3
-        // f'  =      c1   + 2*c2*x + 3*c3*x^2
-        // f'' =             2*c2   + 6*c3*x
         bandMatrix->at(i, (j0-4) + 1) = 1.;            // c1
-        bandMatrix->at(i, (j0-4) + 2) = 2.*nodeX;      // c2
-        bandMatrix->at(i, (j0-4) + 3) = 3.*nodeX2;     // c3
+        bandMatrix->at(i, (j0-4) + 2) = 2.;            // c2
+        bandMatrix->at(i, (j0-4) + 3) = 3.;            // c3
 
-        bandMatrix->at(i, j0 + 1) = (-1.);             // c1
-        bandMatrix->at(i, j0 + 2) = (-2.*nodeX);       // c2
-        bandMatrix->at(i, j0 + 3) = (-3.*nodeX2);      // c3
+        bandMatrix->at(i, j0 + 1) = (-ratio);          // c1
         ++i;
 
-        // 4. Values of derivatives of 2 adjacent curves in nodeIdx
-        // are the same
+        // 4. Values of second derivatives of 2 adjacent curves
+        // in nodeIdx are the same
         bandMatrix->at(i, (j0-4) + 2) = 2.;            // c2
-        bandMatrix->at(i, (j0-4) + 3) = 6.*nodeX;      // c3
+        bandMatrix->at(i, (j0-4) + 3) = 6.;            // c3
 
-        bandMatrix->at(i, j0 + 2) = (-2.);             // c2
-        bandMatrix->at(i, j0 + 3) = (-6.*nodeX);       // c3
+        bandMatrix->at(i, j0 + 2) = (-2.*ratio*ratio); // c2
         ++i;
 
         ++nodeIdx;      // Go to the next node
-        nodeX = nodes[nodeIdx].x;
-        nodeX2 = nodeX*nodeX;
-        nodeX3 = nodeX2*nodeX;
-        nodeY = nodes[nodeIdx].y;
-
     } // end while
 
-    // 1. Last node: value == nodeY
+    // 1. Last node: value == nodeY (t == 1 of the last curve)
     assert(nodeIdx == numNodes - 1);
 
     j0 = nodeIdx*4 - 4;
     assert(j0 == n-4);
 
     bandMatrix->at(i, j0) = 1.;
-    bandMatrix->at(i, j0 + 1) = nodeX;
-    bandMatrix->at(i, j0 + 2) = nodeX2;
-    bandMatrix->at(i, j0 + 3) = nodeX3;
-    bandMatrix->right(i) = nodeY;
+    bandMatrix->at(i, j0 + 1) = 1.;
+    bandMatrix->at(i, j0 + 2) = 1.;
+    bandMatrix->at(i, j0 + 3) = 1.;
+    bandMatrix->right(i) = nodes[nodeIdx].y;
     ++i;
 
     // 2. Last node: second derivative == 0
     bandMatrix->at(i, j0 + 2) = 2.;
-    bandMatrix->at(i, j0 + 3) = 6.*nodeX;
+    bandMatrix->at(i, j0 + 3) = 6.;
+}
+
+// The free terms column of C2-spline system, the same as in fillC2Matrix():
+// rows with node values contain the ordinates, all other rows are zeroes
+void CubicSpline::fillC2Right(double* r) const {
+    assert(numNodes > 1);
+    r[0] = nodes[0].y;
+    r[1] = 0.;
+    int i = 2;
+    for (int nodeIdx = 1; nodeIdx < numNodes - 1; ++nodeIdx) {
+        double nodeY = nodes[nodeIdx].y;
+        r[i] = nodeY;
+        r[i + 1] = nodeY;
+        r[i + 2] = 0.;
+        r[i + 3] = 0.;
+        i += 4;
+    }
+    assert(i == (numNodes - 1)*4 - 2);
+    r[i] = nodes[numNodes - 1].y;
+    r[i + 1] = 0.;
+}
+
+void CubicSpline::setC2Polynomials() {
+    int i = 0;
+    int j0 = 0;
+    while (i < numNodes - 1) {
+        // The coefficients are in the local coordinate of the segment
+        polynomials[i].setLocal(
+            nodes[i].x, nodes[i+1].x - nodes[i].x,
+            coeffs[j0], coeffs[j0 + 1], coeffs[j0 + 2], coeffs[j0 + 3]
+        );
+
+        ++i;
+        j0 += 4;
+    }
+}
+
+// Calculate cubic polynomials so the the spline will be C2-continues,
+// solving a system of linear equarions with band 9-diagonal matrix
+CubicSpline& CubicSpline::interpolateC2() {
+    if (numNodes <= 1)
+        return *this;
 
+    int n = (numNodes - 1)*4;
+    //... BandExtMatrix matr(n, 5, 4);
+    fillC2Matrix();
     if (coeffs == 0) {
         coeffs = new double[n];
     }
@@ -350,16 +283,146 @@ CubicSpline& CubicSpline::interpolateC2() {
     }
 #   endif
 
-    i = 0;
-    j0 = 0;
-    while (i < numNodes - 1) {
-        polynomials[i].coeff[0] = coeffs[j0];
-        polynomials[i].coeff[1] = coeffs[j0 + 1];
-        polynomials[i].coeff[2] = coeffs[j0 + 2];
-        polynomials[i].coeff[3] = coeffs[j0 + 3];
+    setC2Polynomials();
+    return *this;
+}
 
-        ++i;
-        j0 += 4;
+// Fill in the matrix for the current abscissas of nodes
+// and compute its factorization
+bool CubicSpline::factorizeC2() {
+    if (numNodes <= 1)
+        return true;
+    fillC2Matrix();
+    return bandMatrix->factorize();
+}
+
+// Calculate the polynomials of C2-spline for the current ordinates
+// of nodes, using the factorization of this spline (factorized == 0)
+// or of another spline with the same abscissas of nodes
+CubicSpline& CubicSpline::solveC2(
+    const CubicSpline* factorized /* = 0 */
+) {
+    if (numNodes <= 1)
+        return *this;
+    if (factorized == 0)
+        factorized = this;
+    assert(factorized->numNodes == numNodes);
+    assert(
+        factorized->bandMatrix != 0 &&
+        factorized->bandMatrix->factorized
+    );
+
+    int n = (numNodes - 1)*4;
+    if (coeffs == 0) {
+        coeffs = new double[n];
+    }
+    fillC2Right(coeffs);
+    factorized->bandMatrix->solveFactorized(coeffs);
+    setC2Polynomials();
+    return *this;
+}
+
+// Compute the coefficients of the sweep (Thomas) algorithm for the system
+//     h[i-1]*M[i-1] + 2*(h[i-1] + h[i])*M[i] + h[i]*M[i+1] = r[i],
+//     i = 1, ..., numNodes-2,  M[0] = M[numNodes-1] = 0,
+// where h[i] = nodes[i+1].x - nodes[i].x.
+// Forward elimination gives
+//     M[i] = d[i] - sweepC[i]*M[i+1],
+// sweepW[i] is the inverse of the diagonal element after elimination
+bool CubicSpline::factorizeC2Moments() {
+    if (numNodes <= 2)
+        return true;
+    if (sweepC == 0)
+        sweepC = new double[numNodes];
+    if (sweepW == 0)
+        sweepW = new double[numNodes];
+
+    double prevC = 0.;
+    double h0 = nodes[1].x - nodes[0].x;
+    for (int i = 1; i < numNodes - 1; ++i) {
+        double h1 = nodes[i+1].x - nodes[i].x;
+        double z = 2.*(h0 + h1) - h0*prevC;
+        if (fabs(z) <= R2GRAPH_EPSILON)
+            return false;
+        double w = 1./z;
+        sweepW[i] = w;
+        prevC = h1*w;
+        sweepC[i] = prevC;
+        h0 = h1;
+    }
+    return true;
+}
+
+// Calculate the polynomials of C2-spline for the current ordinates
+// of nodes, using the sweep coefficients of this spline (factorized == 0)
+// or of another spline with the same abscissas of nodes
+CubicSpline& CubicSpline::solveC2Moments(
+    const CubicSpline* factorized /* = 0 */
+) {
+    if (numNodes <= 1)
+        return *this;
+    if (factorized == 0)
+        factorized = this;
+    assert(factorized->numNodes == numNodes);
+    if (moments == 0)
+        moments = new double[numNodes];
+
+    moments[0] = 0.;
+    moments[numNodes - 1] = 0.;
+    if (numNodes > 2) {
+        assert(factorized->sweepC != 0 && factorized->sweepW != 0);
+        const double* c = factorized->sweepC;
+        const double* w = factorized->sweepW;
+
+        // Forward sweep
+        double h0 = nodes[1].x - nodes[0].x;
+        double s0 = (nodes[1].y - nodes[0].y)/h0;
+        double d = 0.;
+        for (int i = 1; i < numNodes - 1; ++i) {
+            double h1 = nodes[i+1].x - nodes[i].x;
+            double s1 = (nodes[i+1].y - nodes[i].y)/h1;
+            d = (6.*(s1 - s0) - h0*d)*w[i];
+            moments[i] = d;
+            h0 = h1;
+            s0 = s1;
+        }
+
+        // Back substitution
+        for (int i = numNodes - 3; i >= 1; --i) {
+            moments[i] -= c[i]*moments[i+1];
+        }
+    }
+
+    // Polynomials of segments. In the local coordinate t = (x - x0)/h
+    //     p = y0 + (y1 - y0 - h^2*(2*m0 + m1)/6)*t
+    //         + (h^2*m0/2)*t^2 + (h^2*(m1 - m0)/6)*t^3
+    for (int i = 0; i < numNodes - 1; ++i) {
+        double x0 = nodes[i].x;
+        double h = nodes[i+1].x - x0;
+        double h26 = h*h/6.;
+        double m0 = moments[i];
+        double m1 = moments[i+1];
+        double y0 = nodes[i].y;
+        polynomials[i].setLocal(
+            x0, h,
+            y0,
+            nodes[i+1].y - y0 - h26*(2.*m0 + m1),
+            3.*h26*m0,
+            h26*(m1 - m0)
+        );
     }
     return *this;
 }
+
+// Calculate cubic polynomials so the the spline will be C2-continues,
+// solving a tridiagonal system for the second derivatives in nodes
+CubicSpline& CubicSpline::interpolateC2Moments() {
+    if (numNodes <= 1)
+        return *this;
+#   ifndef NDEBUG
+    bool res =
+#   endif
+    factorizeC2Moments();
+    assert(res);
+    return solveC2Moments();
+}
@@ -5,78 +5,157 @@
 #include "R2Graph.h"
 #include "bandmatrix.h"
 
+// Cubic polynomial in the local coordinate t = (x - origin)*scale:
+//     p(x) = coeff[0] + coeff[1]*t + coeff[2]*t^2 + coeff[3]*t^3.
+// A spline segment [x0, x1] uses origin = x0, scale = 1/(x1 - x0),
+// so t is in [0, 1] and the coefficients have the magnitude of the
+// values, independently of x. With origin = 0, scale = 1
+// the polynomial is in the coordinate x itself.
 class CubicPolynomial {
 public:
     double coeff[4];
+    double origin;
+    double scale;
 
 public:
-    CubicPolynomial() {
+    CubicPolynomial():
+        origin(0.),
+        scale(1.)
+    {
         for (int i = 0; i < 4; ++i)
             coeff[i] = 0.;
     }
 
-    CubicPolynomial(const double* c) {
+    CubicPolynomial(const double* c):
+        origin(0.),
+        scale(1.)
+    {
         for (int i = 0; i < 4; ++i)
             coeff[i] = c[i];
     }
 
-    CubicPolynomial(const std::vector<double>& c) {
+    CubicPolynomial(const std::vector<double>& c):
+        origin(0.),
+        scale(1.)
+    {
         for (int i = 0; i < 4; ++i)
             coeff[i] = c[i];
     }
 
-    double value(double t) const {
-        double v = 0.;
-        for (int i = 3; i >= 0; --i) {
-            v *= t;
-            v += coeff[i];
-        }
-        return v;
+    // Hermite interpolant on the segment [a, b], see interpolate()
+    CubicPolynomial(
+        double a, double b,
+        double value0, double derivative0,
+        double value1, double derivative1
+    ) {
+        interpolate(a, b, value0, derivative0, value1, derivative1);
+    }
+
+    double value(double x) const {
+        return localValue((x - origin)*scale);
+    }
+
+    // Value in the local coordinate t
+    double localValue(double t) const {
+        return ((coeff[3]*t + coeff[2])*t + coeff[1])*t + coeff[0];
     }
 
     double operator[](int i) const { return coeff[i]; }
     double& operator[](int i) { return coeff[i]; }
 
-    double operator()(double t) const { return value(t); }
+    double operator()(double x) const { return value(x); }
+
+    // Forward differences of the polynomial at the points
+    // x, x + dx, x + 2*dx, ...:
+    //     d[0] = p(x), d[1] = p(x + dx) - p(x),
+    //     d[2], d[3] -- the second and the third differences.
+    // Then the values at the next points are obtained by 3 additions:
+    //     d[0] += d[1]; d[1] += d[2]; d[2] += d[3];
+    void forwardDifferences(double x, double dx, double d[4]) const {
+        double t = (x - origin)*scale;
+        double h = dx*scale;
+        double h2 = h*h;
+        double h3 = h2*h;
+        d[0] = localValue(t);
+        d[1] = coeff[1]*h + coeff[2]*(2.*t*h + h2) +
+            coeff[3]*(3.*t*(t*h + h2) + h3);
+        d[2] = 2.*coeff[2]*h2 + 6.*coeff[3]*h2*(t + h);
+        d[3] = 6.*coeff[3]*h3;
+    }
 
     // Interpolate so that
     //     p(a) = value0, dp(a) = derivative0
     //     p(b) = value0, dp(b) = derivative1
-    //
+    // The result is in the local coordinate of segment [a, b]
     CubicPolynomial& interpolate(
         double a, double b,
         double value0, double derivative0,
         double value1, double derivative1
-    );
+    ) {
+        double h = b - a;
+        double d0 = derivative0*h;      // Derivatives by t
+        double d1 = derivative1*h;
+        double dv = value1 - value0;
+        origin = a;
+        scale = 1./h;
+        coeff[0] = value0;
+        coeff[1] = d0;
+        coeff[2] = 3.*dv - 2.*d0 - d1;
+        coeff[3] = d0 + d1 - 2.*dv;
+        return *this;
+    }
+
+    // Set the polynomial in the local coordinate t = (x - x0)/h
+    CubicPolynomial& setLocal(
+        double x0, double h,
+        double c0, double c1, double c2, double c3
+    ) {
+        origin = x0;
+        scale = 1./h;
+        coeff[0] = c0;
+        coeff[1] = c1;
+        coeff[2] = c2;
+        coeff[3] = c3;
+        return *this;
+    }
 
-    // Derivative of polynomial:
+    // Derivative of polynomial (in the same local coordinate):
     CubicPolynomial derivative() const {
         double c[4];
-        c[0] = coeff[1];
-        c[1] = 2.*coeff[2];
-        c[2] = 3.*coeff[3];
+        c[0] = coeff[1]*scale;
+        c[1] = 2.*coeff[2]*scale;
+        c[2] = 3.*coeff[3]*scale;
         c[3] = 0.;
-        return CubicPolynomial(c);
+        CubicPolynomial p(c);
+        p.origin = origin;
+        p.scale = scale;
+        return p;
     }
 
     // Second Derivative
     CubicPolynomial derivative2() const {
+        double s2 = scale*scale;
         double c[4];
-        c[0] = 2*coeff[2];
-        c[1] = 2.*3.*coeff[3];
+        c[0] = 2*coeff[2]*s2;
+        c[1] = 2.*3.*coeff[3]*s2;
         c[2] = 0.;
         c[3] = 0.;
-        return CubicPolynomial(c);
+        CubicPolynomial p(c);
+        p.origin = origin;
+        p.scale = scale;
+        return p;
     }
 
     // Derivative value
     double derivativeValue(double x) const {
-        return ((3.*coeff[3]*x + 2.*coeff[2])*x + coeff[1]);
+        double t = (x - origin)*scale;
+        return ((3.*coeff[3]*t + 2.*coeff[2])*t + coeff[1])*scale;
     }
 
     // Value of second derivative
     double derivative2Value(double x) const {
-        return (6.*coeff[3]*x + 2*coeff[2]);
+        double t = (x - origin)*scale;
+        return (6.*coeff[3]*t + 2*coeff[2])*scale*scale;
     }
 };
 
@@ -90,13 +169,21 @@ private:
     R2Vector* directions;
     BandExtMatrix* bandMatrix;  // C2 Spline: to solve a linear system
     double* coeffs;             // C2 Spline: to solve a linear system
+    double* moments;            // C2 Spline: second derivatives in nodes
+    double* sweepC;             // C2 Spline: tridiagonal sweep coefficients
+    double* sweepW;             // C2 Spline: inverse sweep denominators
 
 public:
     CubicSpline():
         numNodes(0),
         nodes(0),
         polynomials(0),
-        directions(0)
+        directions(0),
+        bandMatrix(0),
+        coeffs(0),
+        moments(0),
+        sweepC(0),
+        sweepW(0)
     {}
 
     CubicSpline(int n):
@@ -105,7 +192,10 @@ public:
         polynomials(new CubicPolynomial[n]),
         directions(new R2Vector[n]),
         bandMatrix(0),
-        coeffs(0)
+        coeffs(0),
+        moments(0),
+        sweepC(0),
+        sweepW(0)
     {}
 
     ~CubicSpline() {
@@ -114,6 +204,9 @@ public:
         delete[] directions;
         delete bandMatrix;
         delete[] coeffs;
+        delete[] moments;
+        delete[] sweepC;
+        delete[] sweepW;
     }
 
     void resize(int n);
@@ -130,8 +223,39 @@ public:
     // solving a system of linear equarions with band 9-diagonal matrix
     CubicSpline& interpolateC2();
 
+    // C2 Spline, factor-once/solve-many mode.
+    // The matrix of the linear system depends only on the abscissas
+    // of nodes. factorizeC2() fills the matrix for the current abscissas
+    // and computes its factorization; after that solveC2() calculates
+    // the polynomials for the current ordinates of nodes. The factorization
+    // of another spline with the same abscissas can be used as well
+    bool factorizeC2();
+    CubicSpline& solveC2(const CubicSpline* factorized = 0);
+
+    // C2 Spline, computed through the second derivatives in nodes
+    // (the moments of the spline). The moments are the solution
+    // of a tridiagonal system that is solved by the sweep (Thomas)
+    // algorithm in O(n) operations, the polynomials of segments are
+    // derived from them. The same natural spline as interpolateC2()
+    // is obtained. Like for the band system, the sweep coefficients
+    // depend only on the abscissas of nodes and can be computed once
+    // for many splines
+    CubicSpline& interpolateC2Moments();
+    bool factorizeC2Moments();
+    CubicSpline& solveC2Moments(const CubicSpline* factorized = 0);
+
+    // Factorizations computed by factorizeC2() and factorizeC2Moments(),
+    // for the splines that keep the ordinates separately (VectorSpline)
+    const BandExtMatrix* c2Matrix() const { return bandMatrix; }
+    const double* c2SweepC() const { return sweepC; }
+    const double* c2SweepW() const { return sweepW; }
+
 private:
     int findSegment(double x) const;    // Binary search
+
+    void fillC2Matrix();                // C2 Spline: the linear system
+    void fillC2Right(double* r) const;  // C2 Spline: the free terms
+    void setC2Polynomials();            // C2 Spline: polynomials from coeffs
 };
 
 #endif
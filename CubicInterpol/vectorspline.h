@@ -0,0 +1,385 @@
+#ifndef VECTOR_SPLINE_H
+#define VECTOR_SPLINE_H
+
+#include <cassert>
+#include "R2Graph.h"
+#include "cubint.h"
+#include "bandmatrix.h"
+
+// Cubic spline with N-dimensional values in nodes (N channels:
+// RGB, RGBA, multispectral data). The abscissas of nodes, the segment
+// search and the factorization of C2 system are common for all channels.
+// For every channel the result is the same as for CubicSpline
+// with the same nodes.
+template <int N>
+class VectorSpline {
+public:
+    int numNodes;
+    double* x;                      // Abscissas, array of numNodes size
+    double* values;                 // Values of node i are values[i*N + c]
+    CubicPolynomial* polynomials;   // Segment i: polynomials[i*N + c]
+
+private:
+    int capacity;           // Size of the arrays, at least numNodes
+    CubicSpline* system;    // C2 Spline: factorization for the abscissas
+    double* work;           // C1 Spline: slopes, C2 Spline: free terms
+                            // or moments
+
+    VectorSpline(const VectorSpline&);
+    VectorSpline& operator=(const VectorSpline&);
+
+public:
+    VectorSpline():
+        numNodes(0),
+        x(0),
+        values(0),
+        polynomials(0),
+        capacity(0),
+        system(0),
+        work(0)
+    {}
+
+    VectorSpline(int n):
+        numNodes(n),
+        x(new double[n]),
+        values(new double[n*N]),
+        polynomials(new CubicPolynomial[n*N]),
+        capacity(n),
+        system(0),
+        work(0)
+    {}
+
+    ~VectorSpline() {
+        delete[] x;
+        delete[] values;
+        delete[] polynomials;
+        delete system;
+        delete[] work;
+    }
+
+    // The arrays are reallocated only when n exceeds all the previous
+    // sizes, so a spline is cheaply reused for windows of different sizes
+    void resize(int n) {
+        if (n == numNodes)
+            return;
+        if (n > capacity) {
+            double* newX = new double[n];
+            double* newValues = new double[n*N];
+            for (int i = 0; i < numNodes; ++i)
+                newX[i] = x[i];
+            for (int i = 0; i < numNodes*N; ++i)
+                newValues[i] = values[i];
+            delete[] x; x = newX;
+            delete[] values; values = newValues;
+            delete[] polynomials;
+            polynomials = new CubicPolynomial[n*N];
+            delete[] work; work = 0;
+            capacity = n;
+        }
+        delete system; system = 0;
+        numNodes = n;
+    }
+
+    // Values of all channels of the spline.
+    // If nodeIdx >= 0, then t belongs
+    // to the interval x[nodeIdx] <= t <= x[nodeIdx+1]
+    void value(double t, int nodeIdx, double* v) const {
+        assert(numNodes > 0);
+        if (numNodes == 1) {
+            for (int c = 0; c < N; ++c)
+                v[c] = values[c];
+            return;
+        }
+        int idx = nodeIdx;
+        if (idx < 0) {
+            idx = findSegment(t);
+            if (idx < 0)
+                idx = 0;
+            else if (idx >= numNodes - 1)
+                idx = numNodes - 2;
+        }
+        assert(0 <= idx && idx < numNodes - 1);
+        // All channels of a segment have the same local coordinate
+        const CubicPolynomial* p = polynomials + idx*N;
+        double s = (t - p[0].origin)*p[0].scale;
+        for (int c = 0; c < N; ++c)
+            v[c] = p[c].localValue(s);
+    }
+
+    // Forward differences of all channels at the points t, t + dt, ...
+    // of the segment nodeIdx: d[c*4 + k], see
+    // CubicPolynomial::forwardDifferences()
+    void forwardDifferences(
+        double t, double dt, int nodeIdx, double* d
+    ) const {
+        assert(numNodes > 0);
+        if (numNodes == 1) {
+            for (int c = 0; c < N; ++c) {
+                d[c*4] = values[c];
+                d[c*4 + 1] = 0.; d[c*4 + 2] = 0.; d[c*4 + 3] = 0.;
+            }
+            return;
+        }
+        assert(0 <= nodeIdx && nodeIdx < numNodes - 1);
+        const CubicPolynomial* p = polynomials + nodeIdx*N;
+        for (int c = 0; c < N; ++c)
+            p[c].forwardDifferences(t, dt, d + c*4);
+    }
+
+    // Calculate cubic polynomials so the the spline will be C1-continues
+    VectorSpline& interpolateC1();
+
+    // C2 Spline with the band 9-diagonal matrix, factor-once/solve-many:
+    // see CubicSpline::factorizeC2(), CubicSpline::solveC2()
+    bool factorizeC2();
+    VectorSpline& solveC2(const VectorSpline* factorized = 0);
+
+    // C2 Spline through the second derivatives in nodes:
+    // see CubicSpline::factorizeC2Moments(), CubicSpline::solveC2Moments()
+    bool factorizeC2Moments();
+    VectorSpline& solveC2Moments(const VectorSpline* factorized = 0);
+
+private:
+    int findSegment(double t) const;    // Binary search
+    void setSystemNodes();
+    void allocateWork();
+};
+
+template <int N>
+int VectorSpline<N>::findSegment(double t) const {
+    assert(numNodes >= 2);
+    if (numNodes < 2 || t < x[0])
+        return (-1);
+    if (t >= x[numNodes - 1])
+        return numNodes - 1;
+    int a = 0; int b = numNodes - 1;
+    while (b - a > 1) {
+        int c = (a + b)/2;
+        if (t < x[c])
+            b = c;
+        else
+            a = c;
+    }
+    return a;
+}
+
+template <int N>
+VectorSpline<N>& VectorSpline<N>::interpolateC1() {
+    assert(numNodes > 1);
+    if (numNodes <= 1)
+        return *this;
+
+    // Slopes in nodes, computed in the same way as
+    // the directions in CubicSpline::interpolateC1()
+    allocateWork();
+    double* slopes = work;
+    if (numNodes == 2) {
+        for (int c = 0; c < N; ++c) {
+            double s = (values[N + c] - values[c])/(x[1] - x[0]);
+            slopes[c] = s;
+            slopes[N + c] = s;
+        }
+    } else {
+        for (int i = 1; i < numNodes - 1; ++i) {
+            double h0 = x[i] - x[i-1];
+            double h1 = x[i+1] - x[i];
+            const double* y = values + i*N;
+            for (int c = 0; c < N; ++c) {
+                R2Vector v0(h0, y[c] - y[c - N]);
+                v0.normalize();
+                R2Vector v1(h1, y[c + N] - y[c]);
+                v1.normalize();
+                R2Vector d = v0 + v1;
+                slopes[i*N + c] = d.y/d.x;
+            }
+        }
+
+        int last = numNodes - 1;
+        double dx0 = (x[1] - x[0])*0.5;
+        double dx1 = (x[last] - x[last-1])*0.5;
+        for (int c = 0; c < N; ++c) {
+            R2Point p(
+                x[1] - dx0,
+                values[N + c] - dx0*slopes[N + c]
+            );
+            R2Vector d = p - R2Point(x[0], values[c]);
+            slopes[c] = d.y/d.x;
+
+            p = R2Point(
+                x[last-1] + dx1,
+                values[(last-1)*N + c] + dx1*slopes[(last-1)*N + c]
+            );
+            d = R2Point(x[last], values[last*N + c]) - p;
+            slopes[last*N + c] = d.y/d.x;
+        }
+    }
+
+    for (int i = 0; i < numNodes - 1; ++i) {
+        for (int c = 0; c < N; ++c) {
+            polynomials[i*N + c].interpolate(
+                x[i], x[i+1],
+                values[i*N + c], slopes[i*N + c],
+                values[(i+1)*N + c], slopes[(i+1)*N + c]
+            );
+        }
+    }
+    return *this;
+}
+
+template <int N>
+void VectorSpline<N>::setSystemNodes() {
+    if (system == 0)
+        system = new CubicSpline(numNodes);
+    assert(system->numNodes == numNodes);
+    for (int i = 0; i < numNodes; ++i) {
+        system->nodes[i].x = x[i];
+        system->nodes[i].y = 0.;
+    }
+}
+
+template <int N>
+void VectorSpline<N>::allocateWork() {
+    if (work == 0) {
+        int size = (capacity - 1)*4;
+        if (size < capacity*N)
+            size = capacity*N;
+        work = new double[size];
+    }
+}
+
+template <int N>
+bool VectorSpline<N>::factorizeC2() {
+    if (numNodes <= 1)
+        return true;
+    setSystemNodes();
+    return system->factorizeC2();
+}
+
+template <int N>
+VectorSpline<N>& VectorSpline<N>::solveC2(
+    const VectorSpline* factorized /* = 0 */
+) {
+    if (numNodes <= 1)
+        return *this;
+    if (factorized == 0)
+        factorized = this;
+    assert(factorized->numNodes == numNodes && factorized->system != 0);
+    const BandExtMatrix* matrix = factorized->system->c2Matrix();
+    assert(matrix != 0 && matrix->factorized);
+    allocateWork();
+
+    // The free terms column of every channel, the same as
+    // in CubicSpline::fillC2Right(), then the solution
+    // gives 4 coefficients of every segment
+    for (int c = 0; c < N; ++c) {
+        double* r = work;
+        r[0] = values[c];
+        r[1] = 0.;
+        int i = 2;
+        for (int nodeIdx = 1; nodeIdx < numNodes - 1; ++nodeIdx) {
+            double nodeY = values[nodeIdx*N + c];
+            r[i] = nodeY;
+            r[i + 1] = nodeY;
+            r[i + 2] = 0.;
+            r[i + 3] = 0.;
+            i += 4;
+        }
+        assert(i == (numNodes - 1)*4 - 2);
+        r[i] = values[(numNodes - 1)*N + c];
+        r[i + 1] = 0.;
+
+        matrix->solveFactorized(r);
+
+        // The coefficients are in the local coordinates of segments,
+        // see CubicSpline::fillC2Matrix()
+        for (int seg = 0; seg < numNodes - 1; ++seg) {
+            polynomials[seg*N + c].setLocal(
+                x[seg], x[seg+1] - x[seg],
+                r[4*seg], r[4*seg + 1], r[4*seg + 2], r[4*seg + 3]
+            );
+        }
+    }
+    return *this;
+}
+
+template <int N>
+bool VectorSpline<N>::factorizeC2Moments() {
+    if (numNodes <= 1)
+        return true;
+    setSystemNodes();
+    return system->factorizeC2Moments();
+}
+
+template <int N>
+VectorSpline<N>& VectorSpline<N>::solveC2Moments(
+    const VectorSpline* factorized /* = 0 */
+) {
+    if (numNodes <= 1)
+        return *this;
+    if (factorized == 0)
+        factorized = this;
+    assert(factorized->numNodes == numNodes);
+    allocateWork();
+
+    // The same sweep as in CubicSpline::solveC2Moments(),
+    // all channels at once
+    double* moments = work;
+    for (int c = 0; c < N; ++c) {
+        moments[c] = 0.;
+        moments[(numNodes - 1)*N + c] = 0.;
+    }
+    if (numNodes > 2) {
+        assert(factorized->system != 0);
+        const double* sweepC = factorized->system->c2SweepC();
+        const double* sweepW = factorized->system->c2SweepW();
+        assert(sweepC != 0 && sweepW != 0);
+
+        double s0[N], d[N];
+        double h0 = x[1] - x[0];
+        for (int c = 0; c < N; ++c) {
+            s0[c] = (values[N + c] - values[c])/h0;
+            d[c] = 0.;
+        }
+        for (int i = 1; i < numNodes - 1; ++i) {
+            double h1 = x[i+1] - x[i];
+            double w = sweepW[i];
+            const double* y = values + i*N;
+            for (int c = 0; c < N; ++c) {
+                double s1 = (y[c + N] - y[c])/h1;
+                d[c] = (6.*(s1 - s0[c]) - h0*d[c])*w;
+                moments[i*N + c] = d[c];
+                s0[c] = s1;
+            }
+            h0 = h1;
+        }
+        for (int i = numNodes - 3; i >= 1; --i) {
+            double sc = sweepC[i];
+            for (int c = 0; c < N; ++c)
+                moments[i*N + c] -= sc*moments[(i+1)*N + c];
+        }
+    }
+
+    // Polynomials of segments in the local coordinates,
+    // see CubicSpline::solveC2Moments()
+    for (int i = 0; i < numNodes - 1; ++i) {
+        double x0 = x[i];
+        double h = x[i+1] - x0;
+        double h26 = h*h/6.;
+        double scale = 1./h;
+        for (int c = 0; c < N; ++c) {
+            double m0 = moments[i*N + c];
+            double m1 = moments[(i+1)*N + c];
+            double y0 = values[i*N + c];
+            CubicPolynomial& p = polynomials[i*N + c];
+            p.origin = x0;
+            p.scale = scale;
+            p.coeff[0] = y0;
+            p.coeff[1] = values[(i+1)*N + c] - y0 - h26*(2.*m0 + m1);
+            p.coeff[2] = 3.*h26*m0;
+            p.coeff[3] = h26*(m1 - m0);
+        }
+    }
+    return *this;
+}
+
+#endif
@@ -0,0 +1,61 @@
+#include <QtGui>
+#include "DisplayPyramid.h"
+
+DisplayPyramid::DisplayPyramid():
+    key(0),
+    images(),
+    pixmaps()
+{}
+
+void DisplayPyramid::setImage(const QImage& image) {
+    if (!isNull() && image.cacheKey() == key)
+        return;
+    clear();
+    if (image.isNull())
+        return;
+    key = image.cacheKey();
+    // The levels are no smaller than a pixel
+    int levels = 1;
+    while (
+        levels <= MAX_PYRAMID_LEVEL &&
+        (image.width() >> levels) > 0 && (image.height() >> levels) > 0
+    )
+        ++levels;
+    images.resize(levels);
+    pixmaps.resize(levels);
+    images[0] = image;      // Shared, not copied
+}
+
+void DisplayPyramid::clear() {
+    key = 0;
+    images.clear();
+    pixmaps.clear();
+}
+
+int DisplayPyramid::levelFor(double scale) const {
+    int level = 0;
+    while (
+        level + 1 < (int) images.size() &&
+        scale*(double)(1 << (level + 1)) <= 1.
+    )
+        ++level;
+    return level;
+}
+
+const QImage& DisplayPyramid::image(int level) {
+    if (images[level].isNull()) {
+        // Each level is the half of the previous one
+        const QImage& finer = image(level - 1);
+        images[level] = finer.scaled(
+            finer.width()/2, finer.height()/2,
+            Qt::IgnoreAspectRatio, Qt::SmoothTransformation
+        );
+    }
+    return images[level];
+}
+
+const QPixmap& DisplayPyramid::pixmap(int level) {
+    if (pixmaps[level].isNull())
+        pixmaps[level] = QPixmap::fromImage(image(level));
+    return pixmaps[level];
+}
@@ -0,0 +1,44 @@
+#ifndef DISPLAY_PYRAMID_H
+#define DISPLAY_PYRAMID_H
+
+#include <vector>
+#include <QImage>
+#include <QPixmap>
+
+// Levels of the pyramid: the last one is 2^MAX_PYRAMID_LEVEL times
+// smaller than the image
+const int MAX_PYRAMID_LEVEL = 6;
+
+// Display cache of an image: the pixmaps of the image reduced 2^k times.
+// A reduced view draws the level of its scale instead of scaling
+// the whole image on every repaint. The levels and their pixmaps are
+// made when they are drawn first and kept until another image is set
+// (the images are compared by QImage::cacheKey, so a changed image
+// is a new one)
+class DisplayPyramid
+{
+public:
+    DisplayPyramid();
+
+    void setImage(const QImage& image);
+    void clear();
+    bool isNull() const { return images.empty(); }
+    int width() const { return isNull()? 0 : images[0].width(); }
+    int height() const { return isNull()? 0 : images[0].height(); }
+
+    // The coarsest level that still has a pixel per pixel
+    // of the view scaled by scale
+    int levelFor(double scale) const;
+
+    // The pixmap of the level (made now if it was not)
+    const QPixmap& pixmap(int level);
+
+private:
+    qint64 key;                     // cacheKey of the image
+    std::vector<QImage> images;     // images[k] is 2^k times smaller
+    std::vector<QPixmap> pixmaps;   // Null -- not made yet
+
+    const QImage& image(int level);
+};
+
+#endif
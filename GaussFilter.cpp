@@ -0,0 +1,474 @@
+#include <cassert>
+#include <cmath>
+#include <vector>
+#if defined(__SSE2__)
+#   include <emmintrin.h>
+#endif
+#include "GaussFilter.h"
+#include "ResampleControl.h"
+
+// Every pass of the filter is a 1-dimensional filter along the lines
+// (rows or columns) of the planes, the sample i of a line is
+// line[i*step + lane]. The rows of all planes are numbered together:
+// the row r is the row r % height of the plane r / height; so are
+// the columns (the lanes of the columns pass)
+struct GaussPass {
+    int width;
+    int height;
+    const PlanarImage* src;
+    PlanarImage* tmp;       // Result of the rows pass (truncated kernel)
+    PlanarImage* dst;
+
+    // Truncated kernel
+    const float* kernel;    // Weights of offsets 0..halfSize
+    int halfSize;
+
+    // Recursive filter: the arithmetic is in doubles, the samples
+    // are stored in floats
+    double b1, b2, b3;      // Feedback coefficients
+    double gain;            // Coefficient of the input sample
+    int tail;               // Zero samples added after the end of line
+    const float* invNormX;  // Inverse norms of the kernel for the columns
+    const float* invNormY;  // and the rows
+    ResampleControl* control;   // Progress and cancellation, may be 0
+};
+
+// Size of the kernel that is not limited by maxSize: the window
+// of +-GAUSS_WINDOW_SIGMAS*sigma, at least 3
+static int gaussFullSize(double sigma) {
+    int s = 1 + 2*(int) ceil(GAUSS_WINDOW_SIGMAS*sigma);
+    return (s < 3)? 3 : s;
+}
+
+void createGaussKernel(
+    double sigma, int maxSize,
+    int& halfSize,
+    double** kernel
+) {
+    assert(sigma > 0.);
+    int s = gaussFullSize(sigma);
+    if (s > maxSize) {
+        s = maxSize;
+        s |= 1;
+    }
+    halfSize = s/2;
+
+    double sigma22 = 2.*sigma*sigma;
+    double* w = new double[halfSize + 1];
+    double norm = 0.;
+    for (int k = 0; k <= halfSize; ++k) {
+        w[k] = exp(-(double)(k*k)/sigma22);
+        norm += (k == 0)? w[k] : 2.*w[k];
+    }
+    for (int k = 0; k <= halfSize; ++k)
+        w[k] /= norm;
+    *kernel = w;
+}
+
+// The method that GAUSS_AUTO stands for
+static int gaussMethod(double sigma, int maxSize, int method) {
+    if (method != GAUSS_AUTO)
+        return method;
+    // The recursive filter is not truncated, so it is used only
+    // when the kernel is not limited by maxSize: then both
+    // approximate the same Gaussian
+    if (
+        sigma >= GAUSS_RECURSIVE_SIGMA && gaussFullSize(sigma) <= maxSize
+    )
+        return GAUSS_RECURSIVE;
+    return GAUSS_TRUNCATED;
+}
+
+int gaussHalo(
+    double sigma, int maxSize,
+    int method  /* = GAUSS_AUTO */
+) {
+    if (gaussMethod(sigma, maxSize, method) == GAUSS_RECURSIVE)
+        return (-1);
+    int halfSize;
+    double* kernel = 0;
+    createGaussKernel(sigma, maxSize, halfSize, &kernel);
+    delete[] kernel;
+    return halfSize;
+}
+
+// Interior samples of lines: the kernel covers the whole window.
+//     dst[j] = sum_k w[|k|]*center[j + k*step], k = -halfSize..halfSize,
+// j = 0..length-1. The samples j are along the memory (for a row:
+// the interior samples of the row, for the columns: the whole row
+// of the image). With SSE2 16 samples (a cache line) are summed
+// at once in registers; the operations are in the order of the scalar
+// loop, so the results are the same
+static void gaussSpan(
+    const float* center, float* dst, int length, ptrdiff_t step,
+    const float* w, int halfSize
+) {
+    float w0 = w[0];
+    int j = 0;
+#if defined(__SSE2__)
+    const __m128 vw0 = _mm_set1_ps(w0);
+    for (; j + 16 <= length; j += 16) {
+        const float* c = center + j;
+        __m128 s0 = _mm_mul_ps(vw0, _mm_loadu_ps(c));
+        __m128 s1 = _mm_mul_ps(vw0, _mm_loadu_ps(c + 4));
+        __m128 s2 = _mm_mul_ps(vw0, _mm_loadu_ps(c + 8));
+        __m128 s3 = _mm_mul_ps(vw0, _mm_loadu_ps(c + 12));
+        for (int k = 1; k <= halfSize; ++k) {
+            const float* a = c - k*step;
+            const float* b = c + k*step;
+            __m128 wk = _mm_set1_ps(w[k]);
+            s0 = _mm_add_ps(s0, _mm_mul_ps(
+                wk, _mm_add_ps(_mm_loadu_ps(a), _mm_loadu_ps(b))
+            ));
+            s1 = _mm_add_ps(s1, _mm_mul_ps(
+                wk, _mm_add_ps(_mm_loadu_ps(a + 4), _mm_loadu_ps(b + 4))
+            ));
+            s2 = _mm_add_ps(s2, _mm_mul_ps(
+                wk, _mm_add_ps(_mm_loadu_ps(a + 8), _mm_loadu_ps(b + 8))
+            ));
+            s3 = _mm_add_ps(s3, _mm_mul_ps(
+                wk, _mm_add_ps(_mm_loadu_ps(a + 12), _mm_loadu_ps(b + 12))
+            ));
+        }
+        _mm_storeu_ps(dst + j, s0);
+        _mm_storeu_ps(dst + j + 4, s1);
+        _mm_storeu_ps(dst + j + 8, s2);
+        _mm_storeu_ps(dst + j + 12, s3);
+    }
+#endif
+    for (; j < length; ++j) {
+        const float* c = center + j;
+        float v = w0*c[0];
+        for (int k = 1; k <= halfSize; ++k)
+            v += w[k]*(c[-k*step] + c[k*step]);
+        dst[j] = v;
+    }
+}
+
+// Sample i of the line near its ends: only the samples inside the line
+// are used, the result is divided by the sum of their weights
+static void gaussBorderSample(
+    const float* line, float* dst, int n, int i, ptrdiff_t step,
+    int numLanes, const float* w, int halfSize
+) {
+    int k0 = (-halfSize);
+    if (i + k0 < 0)
+        k0 = (-i);
+    int k1 = halfSize;
+    if (i + k1 > n - 1)
+        k1 = n - 1 - i;
+
+    float* d = dst + i*step;
+    for (int lane = 0; lane < numLanes; ++lane)
+        d[lane] = 0.f;
+    float norm = 0.f;
+    for (int k = k0; k <= k1; ++k) {
+        float wk = w[(k >= 0)? k : (-k)];
+        const float* s = line + (i + k)*step;
+        for (int lane = 0; lane < numLanes; ++lane)
+            d[lane] += wk*s[lane];
+        norm += wk;
+    }
+    assert(norm > 0.f);
+    float invNorm = 1.f/norm;
+    for (int lane = 0; lane < numLanes; ++lane)
+        d[lane] *= invNorm;
+}
+
+// Truncated kernel: the rows r0 <= r < r1 of the planes
+static void gaussRowsTruncated(const GaussPass& pass, int r0, int r1) {
+    int n = pass.width;
+    int h = pass.halfSize;
+    for (int r = r0; r < r1; ++r) {
+        if (isCancelled(pass.control))
+            return;
+        int c = r/pass.height;
+        int y = r%pass.height;
+        const float* src = pass.src->row(c, y);
+        float* dst = pass.tmp->row(c, y);
+        int interior0 = h;
+        int interior1 = n - h;
+        if (interior1 < interior0)
+            interior1 = interior0 = n;
+        if (interior1 > interior0)
+            gaussSpan(
+                src + interior0, dst + interior0,
+                interior1 - interior0, 1, pass.kernel, h
+            );
+        for (int i = 0; i < interior0; ++i)
+            gaussBorderSample(src, dst, n, i, 1, 1, pass.kernel, h);
+        for (int i = interior1; i < n; ++i)
+            gaussBorderSample(src, dst, n, i, 1, 1, pass.kernel, h);
+        addRowsDone(pass.control, 1);
+    }
+}
+
+// Truncated kernel: the rows r0 <= r < r1 of the result,
+// every row is a combination of 2*halfSize + 1 rows of its plane
+static void gaussColumnsTruncated(const GaussPass& pass, int r0, int r1) {
+    int n = pass.height;
+    int h = pass.halfSize;
+    int stride = pass.tmp->stride;
+    for (int r = r0; r < r1; ++r) {
+        if (isCancelled(pass.control))
+            return;
+        int c = r/n;
+        int y = r%n;
+        if (y >= h && y < n - h)
+            gaussSpan(
+                pass.tmp->row(c, y), pass.dst->row(c, y),
+                pass.width, stride, pass.kernel, h
+            );
+        else
+            gaussBorderSample(
+                pass.tmp->planes[c], pass.dst->planes[c], n, y, stride,
+                pass.width, pass.kernel, h
+            );
+        addRowsDone(pass.control, 1);
+    }
+}
+
+// Coefficients of the recursive Gaussian filter:
+// I.T. Young, L.J. van Vliet, "Recursive implementation of the Gaussian
+// filter", Signal Processing 44 (1995)
+static void setRecursiveCoeffs(GaussPass& pass, double sigma) {
+    if (sigma < 0.5)
+        sigma = 0.5;    // The approximation is not valid for smaller sigma
+    double q;
+    if (sigma >= 2.5)
+        q = 0.98711*sigma - 0.96330;
+    else
+        q = 3.97156 - 4.14554*sqrt(1. - 0.26891*sigma);
+    double q2 = q*q;
+    double q3 = q2*q;
+    double b0 = 1.57825 + 2.44413*q + 1.4281*q2 + 0.422205*q3;
+    double b1 = (2.44413*q + 2.85619*q2 + 1.26661*q3)/b0;
+    double b2 = (-(1.4281*q2 + 1.26661*q3))/b0;
+    double b3 = (0.422205*q3)/b0;
+    pass.b1 = b1;
+    pass.b2 = b2;
+    pass.b3 = b3;
+    pass.gain = 1. - (b1 + b2 + b3);
+
+    // The impulse response of the causal filter decays slower
+    // than the Gaussian; after the tail it is negligible
+    pass.tail = (int)(6.*sigma) + 8;
+}
+
+// Sample i of the line extended by the tail: the samples 0..n-1 are
+// data[i*step], the samples n..n+tail-1 are tail[(i-n)*tailStep]
+static inline float* gaussSample(
+    float* data, int n, ptrdiff_t step, float* tail, int tailStep, int i
+) {
+    return (i < n)? data + i*step : tail + (i - n)*tailStep;
+}
+
+// The causal and anti-causal passes over n samples of numLanes lanes
+// in place. The line is extended by pass.tail zero samples in the tail
+// buffer, the initial state of both passes is zero, so the result
+// is the convolution of the line extended by zeros
+static void gaussRecursive(
+    const GaussPass& pass, float* data, int n, ptrdiff_t step,
+    float* tail, int tailStep, int numLanes
+) {
+    const double b1 = pass.b1, b2 = pass.b2, b3 = pass.b3;
+    const double gain = pass.gain;
+    int total = n + pass.tail;
+    for (int i = 0; i < pass.tail; ++i) {
+        float* c = tail + i*tailStep;
+        for (int lane = 0; lane < numLanes; ++lane)
+            c[lane] = 0.f;
+    }
+
+    // Causal pass
+    int i;
+    for (i = 0; i < total && i < 3; ++i) {
+        float* c = gaussSample(data, n, step, tail, tailStep, i);
+        for (int lane = 0; lane < numLanes; ++lane)
+            c[lane] *= gain;
+        for (int k = 1; k <= i; ++k) {
+            const float* ck =
+                gaussSample(data, n, step, tail, tailStep, i - k);
+            double b = (k == 1)? b1 : b2;
+            for (int lane = 0; lane < numLanes; ++lane)
+                c[lane] += b*ck[lane];
+        }
+    }
+    for (; i < total; ++i) {
+        float* c = gaussSample(data, n, step, tail, tailStep, i);
+        const float* c1 = gaussSample(data, n, step, tail, tailStep, i-1);
+        const float* c2 = gaussSample(data, n, step, tail, tailStep, i-2);
+        const float* c3 = gaussSample(data, n, step, tail, tailStep, i-3);
+        for (int lane = 0; lane < numLanes; ++lane)
+            c[lane] = gain*c[lane] +
+                b1*c1[lane] + b2*c2[lane] + b3*c3[lane];
+    }
+
+    // Anti-causal pass
+    for (i = total - 1; i >= 0 && i >= total - 3; --i) {
+        float* c = gaussSample(data, n, step, tail, tailStep, i);
+        for (int lane = 0; lane < numLanes; ++lane)
+            c[lane] *= gain;
+        for (int k = 1; k <= total - 1 - i; ++k) {
+            const float* ck =
+                gaussSample(data, n, step, tail, tailStep, i + k);
+            double b = (k == 1)? b1 : b2;
+            for (int lane = 0; lane < numLanes; ++lane)
+                c[lane] += b*ck[lane];
+        }
+    }
+    for (; i >= 0; --i) {
+        float* c = gaussSample(data, n, step, tail, tailStep, i);
+        const float* c1 = gaussSample(data, n, step, tail, tailStep, i+1);
+        const float* c2 = gaussSample(data, n, step, tail, tailStep, i+2);
+        const float* c3 = gaussSample(data, n, step, tail, tailStep, i+3);
+        for (int lane = 0; lane < numLanes; ++lane)
+            c[lane] = gain*c[lane] +
+                b1*c1[lane] + b2*c2[lane] + b3*c3[lane];
+    }
+}
+
+// Inverse of the filtered indicator of the line [0, n):
+// the norm of the kernel over the samples inside the line
+static void gaussRecursiveNorms(const GaussPass& pass, int n, float* inv) {
+    std::vector<float> tail(pass.tail);
+    for (int i = 0; i < n; ++i)
+        inv[i] = 1.f;
+    gaussRecursive(pass, inv, n, 1, tail.data(), 1, 1);
+    for (int i = 0; i < n; ++i)
+        inv[i] = 1.f/inv[i];
+}
+
+// Number of rows filtered together by the recursive filter
+const int GAUSS_ROW_BLOCK = 8;
+
+// Recursive filter: the rows r0 <= r < r1 of the planes,
+// from pass.src to pass.dst. The recursion along one row is
+// sequential, so blocks of rows are interleaved into a buffer
+// (the sample i of the row k of the block is buffer[i*numRows + k])
+// and filtered as lanes of one line
+static void gaussRowsRecursive(const GaussPass& pass, int r0, int r1) {
+    int n = pass.width;
+    std::vector<float> buffer(n*GAUSS_ROW_BLOCK);
+    std::vector<float> tail(pass.tail*GAUSS_ROW_BLOCK);
+    for (int block = r0; block < r1; block += GAUSS_ROW_BLOCK) {
+        if (isCancelled(pass.control))
+            return;
+        int numRows = r1 - block;
+        if (numRows > GAUSS_ROW_BLOCK)
+            numRows = GAUSS_ROW_BLOCK;
+        for (int k = 0; k < numRows; ++k) {
+            int r = block + k;
+            const float* src = pass.src->row(r/pass.height, r%pass.height);
+            for (int i = 0; i < n; ++i)
+                buffer[i*numRows + k] = src[i];
+        }
+        gaussRecursive(
+            pass, buffer.data(), n, numRows, tail.data(), numRows, numRows
+        );
+        for (int k = 0; k < numRows; ++k) {
+            int r = block + k;
+            float* dst = pass.dst->row(r/pass.height, r%pass.height);
+            for (int i = 0; i < n; ++i)
+                dst[i] = buffer[i*numRows + k]*pass.invNormX[i];
+        }
+        addRowsDone(pass.control, numRows);
+    }
+}
+
+// Recursive filter: the columns l0 <= l < l1 of the planes
+// (the column l is the column l % width of the plane l / width),
+// the columns of a plane are filtered at once, in place
+static void gaussColumnsRecursive(const GaussPass& pass, int l0, int l1) {
+    int width = pass.width;
+    int stride = pass.dst->stride;
+    std::vector<float> tail((l1 - l0)*pass.tail);
+    int l = l0;
+    while (l < l1) {
+        if (isCancelled(pass.control))
+            return;
+        int c = l/width;
+        int lane0 = l%width;
+        int lane1 = width;
+        if (c*width + lane1 > l1)
+            lane1 = l1 - c*width;
+        int numLanes = lane1 - lane0;
+        gaussRecursive(
+            pass, pass.dst->planes[c] + lane0, pass.height, stride,
+            tail.data(), numLanes, numLanes
+        );
+        for (int y = 0; y < pass.height; ++y) {
+            float* d = pass.dst->row(c, y);
+            float norm = pass.invNormY[y];
+            for (int i = lane0; i < lane1; ++i)
+                d[i] *= norm;
+        }
+        addRowsDone(pass.control, numLanes);
+        l = c*width + lane1;
+    }
+}
+
+void gaussFilter(
+    const PlanarImage& image,
+    PlanarImage& filtered,
+    double sigma,
+    int maxSize,
+    int method,     /* = GAUSS_AUTO */
+    int numThreads, /* = 0 */
+    ResampleControl* control    /* = 0 */
+) {
+    assert(sigma > 0.);
+    int imageWidth = image.width;
+    int imageHeight = image.height;
+    if (imageWidth <= 0 || imageHeight <= 0)
+        return;
+    filtered.create(imageWidth, imageHeight);
+
+    GaussPass pass;
+    pass.width = imageWidth;
+    pass.height = imageHeight;
+    pass.src = &image;
+    pass.dst = &filtered;
+    pass.control = control;
+
+    double* kernel = 0;
+    createGaussKernel(sigma, maxSize, pass.halfSize, &kernel);
+    std::vector<float> kernelF(pass.halfSize + 1);
+    for (int k = 0; k <= pass.halfSize; ++k)
+        kernelF[k] = (float) kernel[k];
+    delete[] kernel;
+    pass.kernel = kernelF.data();
+    method = gaussMethod(sigma, maxSize, method);
+
+    int numRows = NUM_PLANES*imageHeight;
+    if (method == GAUSS_TRUNCATED) {
+        PlanarImage tmp(imageWidth, imageHeight);
+        pass.tmp = &tmp;
+        addRowsTotal(control, 2*numRows);
+        runThreadRanges(gaussRowsTruncated, pass, 0, numRows, numThreads);
+        if (isCancelled(control))
+            return;
+        runThreadRanges(
+            gaussColumnsTruncated, pass, 0, numRows, numThreads
+        );
+    } else {
+        assert(method == GAUSS_RECURSIVE);
+        setRecursiveCoeffs(pass, sigma);
+        std::vector<float> invNormX(imageWidth);
+        std::vector<float> invNormY(imageHeight);
+        gaussRecursiveNorms(pass, imageWidth, invNormX.data());
+        gaussRecursiveNorms(pass, imageHeight, invNormY.data());
+        pass.invNormX = invNormX.data();
+        pass.invNormY = invNormY.data();
+
+        pass.tmp = 0;
+        addRowsTotal(control, numRows + NUM_PLANES*imageWidth);
+        runThreadRanges(gaussRowsRecursive, pass, 0, numRows, numThreads);
+        if (isCancelled(control))
+            return;
+        runThreadRanges(
+            gaussColumnsRecursive, pass, 0, NUM_PLANES*imageWidth,
+            numThreads
+        );
+    }
+}
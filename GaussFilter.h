@@ -0,0 +1,67 @@
+#ifndef GAUSS_FILTER_H
+#define GAUSS_FILTER_H
+
+#include "PlanarImage.h"
+
+class ResampleControl;
+
+// Methods of Gaussian filter
+enum GaussMethod {
+    GAUSS_AUTO = 0,         // Truncated kernel for small sigma,
+                            // recursive filter for large sigma
+    GAUSS_TRUNCATED = 1,    // Kernel of +-3*sigma (at most maxSize)
+    GAUSS_RECURSIVE = 2     // Recursive (IIR) filter of the 3rd order,
+                            // not truncated, the cost does not depend
+                            // on sigma
+};
+
+// GAUSS_AUTO uses the recursive filter when sigma is at least this value
+// and the kernel is not truncated by maxSize
+const double GAUSS_RECURSIVE_SIGMA = 4.;
+
+// The truncated kernel covers +-GAUSS_WINDOW_SIGMAS*sigma, where
+// the Gaussian falls to 1% of its peak: without the limit of maxSize
+// it is the same filter as the recursive one
+const double GAUSS_WINDOW_SIGMAS = 3.;
+
+// Gaussian filter of the image. The kernel
+//     exp(-(dx*dx + dy*dy)/(2*sigma*sigma))
+// is separable: the rows are filtered, then the columns.
+// Near the borders the kernel is normalized over the pixels inside
+// the image, so the borders are neither darkened nor extended.
+// The recursive filter (Young, van Vliet) approximates the Gaussian
+// with 3 poles; the truncated kernel is exact inside its window.
+// The planes are filtered independently; filtered is (re)allocated
+// with the size of image
+void gaussFilter(
+    const PlanarImage& image,
+    PlanarImage& filtered,
+    double sigma,
+    int maxSize,            // Maximal size of the truncated kernel
+    int method = GAUSS_AUTO,
+    int numThreads = 0,     // 0 -- use all processors
+    ResampleControl* control = 0    // Progress and cancellation
+);
+
+// Distance in pixels (along the rows and the columns) of the source
+// pixels a filtered pixel depends on: halfSize of the truncated kernel,
+// -1 for the recursive filter (the whole lines). A part of the result
+// is exact when the part of the source around it by this distance is
+// filtered: the kernel is normalized only at the borders of the image
+int gaussHalo(
+    double sigma, int maxSize,
+    int method = GAUSS_AUTO
+);
+
+// 1-dimensional truncated Gaussian kernel: the weights of offsets
+// 0, 1, ..., halfSize (the kernel is symmetric), normalized so that
+// the sum over -halfSize..halfSize is 1.
+// The size of the kernel 2*halfSize + 1 is 1 + 2*ceil(3*sigma),
+// at least 3, but not larger than maxSize (made odd)
+void createGaussKernel(
+    double sigma, int maxSize,
+    int& halfSize,
+    double** kernel
+);
+
+#endif
@@ -10,15 +10,16 @@ greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
 TARGET = ImView
 TEMPLATE = app
+CONFIG += c++11 thread
 
 
+include(engines.pri)
+
 SOURCES += main.cpp \
-        mainwindow.cpp drawarea.cpp RealPixel.cpp \
-        CubicInterpol/cubint.cpp CubicInterpol/bandmatrix.cpp
+        mainwindow.cpp drawarea.cpp QImagePlanes.cpp ResampleTask.cpp \
+        TileCache.cpp DisplayPyramid.cpp
 
-HEADERS  += mainwindow.h drawarea.h RealPixel.h \
-        CubicInterpol/cubint.h CubicInterpol/bandmatrix.h CubicInterpol/R2Graph.h
+HEADERS  += mainwindow.h drawarea.h QImagePlanes.h ResampleTask.h \
+        TileCache.h DisplayPyramid.h
 
 FORMS    += mainwindow.ui
-
-CONFIG(release, debug|release): DEFINES += NDEBUG
@@ -0,0 +1,241 @@
+#include <cassert>
+#include <cstring>
+#include <vector>
+#if defined(__SSE2__)
+#   include <emmintrin.h>
+#endif
+#include "ImageConvert.h"
+
+const float UNIT_PER_BYTE = 1.f/255.f;
+
+struct ConvertPass {
+    int width;
+    const unsigned char* src;       // 8-bit image of import
+    unsigned char* dst;             // 8-bit image of export
+    int bytesPerLine;
+    int layout;
+    const PlanarImage* image;       // Planes of export
+    PlanarImage* planes;            // Planes of import
+};
+
+// Nearest integer of v*255 clamped to 0..255 (NaN gives 0)
+static inline int unitToByte(float v) {
+    float t = v*255.f + 0.5f;
+    if (!(t > 0.f))
+        return 0;
+    if (t >= 255.f)
+        return 255;
+    return (int) t;
+}
+
+#if defined(__SSE2__)
+// unitToByte of 4 values in 32-bit lanes
+static inline __m128i unitToByte4(__m128 v) {
+    v = _mm_add_ps(_mm_mul_ps(v, _mm_set1_ps(255.f)), _mm_set1_ps(0.5f));
+    // max returns the second operand for NaN
+    v = _mm_min_ps(_mm_max_ps(v, _mm_setzero_ps()), _mm_set1_ps(255.f));
+    return _mm_cvttps_epi32(v);
+}
+#endif
+
+// Bytes of one channel to [0, 1]: n values
+static void bytesToUnits(const unsigned char* src, float* dst, int n) {
+    int x = 0;
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 scale = _mm_set1_ps(UNIT_PER_BYTE);
+    for (; x + 16 <= n; x += 16) {
+        __m128i b = _mm_loadu_si128((const __m128i*)(src + x));
+        __m128i lo = _mm_unpacklo_epi8(b, zero);
+        __m128i hi = _mm_unpackhi_epi8(b, zero);
+        __m128i w[4] = {
+            _mm_unpacklo_epi16(lo, zero), _mm_unpackhi_epi16(lo, zero),
+            _mm_unpacklo_epi16(hi, zero), _mm_unpackhi_epi16(hi, zero)
+        };
+        for (int k = 0; k < 4; ++k)
+            _mm_storeu_ps(
+                dst + x + 4*k, _mm_mul_ps(_mm_cvtepi32_ps(w[k]), scale)
+            );
+    }
+#endif
+    for (; x < n; ++x)
+        dst[x] = (float) src[x]*UNIT_PER_BYTE;
+}
+
+// Values of one channel to bytes with rounding and clamping: n values
+static void unitsToBytes(const float* src, unsigned char* dst, int n) {
+    int x = 0;
+#if defined(__SSE2__)
+    for (; x + 16 <= n; x += 16) {
+        __m128i a = unitToByte4(_mm_loadu_ps(src + x));
+        __m128i b = unitToByte4(_mm_loadu_ps(src + x + 4));
+        __m128i c = unitToByte4(_mm_loadu_ps(src + x + 8));
+        __m128i d = unitToByte4(_mm_loadu_ps(src + x + 12));
+        __m128i ab = _mm_packs_epi32(a, b);
+        __m128i cd = _mm_packs_epi32(c, d);
+        _mm_storeu_si128((__m128i*)(dst + x), _mm_packus_epi16(ab, cd));
+    }
+#endif
+    for (; x < n; ++x)
+        dst[x] = (unsigned char) unitToByte(src[x]);
+}
+
+// 32-bit pixels 0xAARRGGBB to the rows of planes
+static void importXRGB32(
+    const unsigned int* src, float* red, float* green, float* blue, int n
+) {
+    int x = 0;
+#if defined(__SSE2__)
+    const __m128i mask = _mm_set1_epi32(0xFF);
+    const __m128 scale = _mm_set1_ps(UNIT_PER_BYTE);
+    for (; x + 4 <= n; x += 4) {
+        __m128i p = _mm_loadu_si128((const __m128i*)(src + x));
+        __m128i r = _mm_and_si128(_mm_srli_epi32(p, 16), mask);
+        __m128i g = _mm_and_si128(_mm_srli_epi32(p, 8), mask);
+        __m128i b = _mm_and_si128(p, mask);
+        _mm_storeu_ps(red + x, _mm_mul_ps(_mm_cvtepi32_ps(r), scale));
+        _mm_storeu_ps(green + x, _mm_mul_ps(_mm_cvtepi32_ps(g), scale));
+        _mm_storeu_ps(blue + x, _mm_mul_ps(_mm_cvtepi32_ps(b), scale));
+    }
+#endif
+    for (; x < n; ++x) {
+        unsigned int p = src[x];
+        red[x] = (float)((p >> 16) & 0xFF)*UNIT_PER_BYTE;
+        green[x] = (float)((p >> 8) & 0xFF)*UNIT_PER_BYTE;
+        blue[x] = (float)(p & 0xFF)*UNIT_PER_BYTE;
+    }
+}
+
+// The rows of planes to 32-bit pixels 0xFFRRGGBB
+static void exportXRGB32(
+    const float* red, const float* green, const float* blue,
+    unsigned int* dst, int n
+) {
+    int x = 0;
+#if defined(__SSE2__)
+    const __m128i alpha = _mm_set1_epi32((int) 0xFF000000u);
+    for (; x + 4 <= n; x += 4) {
+        __m128i r = unitToByte4(_mm_loadu_ps(red + x));
+        __m128i g = unitToByte4(_mm_loadu_ps(green + x));
+        __m128i b = unitToByte4(_mm_loadu_ps(blue + x));
+        __m128i p = _mm_or_si128(
+            _mm_or_si128(_mm_slli_epi32(r, 16), _mm_slli_epi32(g, 8)),
+            _mm_or_si128(b, alpha)
+        );
+        _mm_storeu_si128((__m128i*)(dst + x), p);
+    }
+#endif
+    for (; x < n; ++x) {
+        dst[x] = 0xFF000000u |
+            ((unsigned int) unitToByte(red[x]) << 16) |
+            ((unsigned int) unitToByte(green[x]) << 8) |
+            (unsigned int) unitToByte(blue[x]);
+    }
+}
+
+// Import of the rows y0 <= y < y1. The layouts of bytes are split
+// into channels first, then the channels are converted by blocks
+static void importRows(const ConvertPass& pass, int y0, int y1) {
+    int n = pass.width;
+    std::vector<unsigned char> channels(3*n);
+    unsigned char* r8 = channels.data();
+    unsigned char* g8 = r8 + n;
+    unsigned char* b8 = g8 + n;
+    PlanarImage& image = *pass.planes;
+    for (int y = y0; y < y1; ++y) {
+        const unsigned char* src = pass.src + (size_t) y*pass.bytesPerLine;
+        float* red = image.row(PLANE_RED, y);
+        float* green = image.row(PLANE_GREEN, y);
+        float* blue = image.row(PLANE_BLUE, y);
+        if (pass.layout == PIXELS_XRGB32) {
+            importXRGB32((const unsigned int*) src, red, green, blue, n);
+        } else if (pass.layout == PIXELS_RGB888) {
+            for (int x = 0; x < n; ++x) {
+                r8[x] = src[3*x];
+                g8[x] = src[3*x + 1];
+                b8[x] = src[3*x + 2];
+            }
+            bytesToUnits(r8, red, n);
+            bytesToUnits(g8, green, n);
+            bytesToUnits(b8, blue, n);
+        } else {
+            assert(pass.layout == PIXELS_GRAY8);
+            bytesToUnits(src, red, n);
+            memcpy(green, red, n*sizeof(float));
+            memcpy(blue, red, n*sizeof(float));
+        }
+    }
+}
+
+// Export of the rows y0 <= y < y1
+static void exportRows(const ConvertPass& pass, int y0, int y1) {
+    int n = pass.width;
+    std::vector<unsigned char> channels(3*n);
+    std::vector<float> luminance(n);
+    unsigned char* r8 = channels.data();
+    unsigned char* g8 = r8 + n;
+    unsigned char* b8 = g8 + n;
+    const PlanarImage& image = *pass.image;
+    for (int y = y0; y < y1; ++y) {
+        unsigned char* dst = pass.dst + (size_t) y*pass.bytesPerLine;
+        const float* red = image.row(PLANE_RED, y);
+        const float* green = image.row(PLANE_GREEN, y);
+        const float* blue = image.row(PLANE_BLUE, y);
+        if (pass.layout == PIXELS_XRGB32) {
+            exportXRGB32(red, green, blue, (unsigned int*) dst, n);
+        } else if (pass.layout == PIXELS_RGB888) {
+            unitsToBytes(red, r8, n);
+            unitsToBytes(green, g8, n);
+            unitsToBytes(blue, b8, n);
+            for (int x = 0; x < n; ++x) {
+                dst[3*x] = r8[x];
+                dst[3*x + 1] = g8[x];
+                dst[3*x + 2] = b8[x];
+            }
+        } else {
+            assert(pass.layout == PIXELS_GRAY8);
+            float* l = luminance.data();
+            for (int x = 0; x < n; ++x)
+                l[x] = 0.2126f*red[x] + 0.7152f*green[x] + 0.0722f*blue[x];
+            unitsToBytes(l, dst, n);
+        }
+    }
+}
+
+void importPixels(
+    int width, int height,
+    const unsigned char* bits, int bytesPerLine, int layout,
+    PlanarImage& image,
+    int numThreads  /* = 0 */
+) {
+    image.create(width, height);
+    if (width <= 0 || height <= 0)
+        return;
+    ConvertPass pass;
+    pass.width = width;
+    pass.src = bits;
+    pass.dst = 0;
+    pass.bytesPerLine = bytesPerLine;
+    pass.layout = layout;
+    pass.image = 0;
+    pass.planes = &image;
+    runThreadRanges(importRows, pass, 0, height, numThreads);
+}
+
+void exportPixels(
+    const PlanarImage& image,
+    unsigned char* bits, int bytesPerLine, int layout,
+    int numThreads  /* = 0 */
+) {
+    if (image.width <= 0 || image.height <= 0)
+        return;
+    ConvertPass pass;
+    pass.width = image.width;
+    pass.src = 0;
+    pass.dst = bits;
+    pass.bytesPerLine = bytesPerLine;
+    pass.layout = layout;
+    pass.image = &image;
+    pass.planes = 0;
+    runThreadRanges(exportRows, pass, 0, image.height, numThreads);
+}
@@ -0,0 +1,44 @@
+#ifndef IMAGE_CONVERT_H
+#define IMAGE_CONVERT_H
+
+#include "PlanarImage.h"
+
+// Layouts of 8-bit pixels in the scanlines of images
+enum PixelLayout {
+    PIXELS_XRGB32 = 0,      // 32-bit words 0xAARRGGBB in the native byte
+                            // order (QImage::Format_RGB32, Format_ARGB32),
+                            // alpha is ignored on import, 0xFF on export
+    PIXELS_RGB888 = 1,      // Bytes R, G, B (QImage::Format_RGB888)
+    PIXELS_GRAY8 = 2        // One byte (QImage::Format_Grayscale8),
+                            // the luminance 0.2126 R + 0.7152 G + 0.0722 B
+                            // on export
+};
+
+// Conversion of 8-bit scanlines to the planes and back.
+// The rows of the 8-bit image are given by the pointer to the first
+// row and the distance between rows in bytes, so the scanlines of
+// QImage are used directly:
+//     importPixels(
+//         src.width(), src.height(), src.constBits(), src.bytesPerLine(),
+//         PIXELS_XRGB32, image
+//     );
+// The import maps 0..255 to [0, 1]; the export rounds v*255 to the
+// nearest integer and clamps it to 0..255 in the same pass.
+// The rows are converted by SSE2 (when the compiler targets it)
+// in blocks of pixels, the rows are divided between threads.
+// image is (re)allocated with the size width x height
+void importPixels(
+    int width, int height,
+    const unsigned char* bits, int bytesPerLine, int layout,
+    PlanarImage& image,
+    int numThreads = 0      // 0 -- use all processors
+);
+
+// bits must have image.height rows of image.width pixels
+void exportPixels(
+    const PlanarImage& image,
+    unsigned char* bits, int bytesPerLine, int layout,
+    int numThreads = 0      // 0 -- use all processors
+);
+
+#endif
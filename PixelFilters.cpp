@@ -0,0 +1,113 @@
+#include <cassert>
+#include <cstring>
+#include <vector>
+#include "PixelFilters.h"
+#include "ResampleControl.h"
+
+// The rows of the images. For the high-pass filter the rows of all
+// planes are numbered together: the row r is the row r % height
+// of the plane r / height
+struct FilterPass {
+    int width;
+    int height;
+    const PlanarImage* src;
+    PlanarImage* dst;
+    double contrast;
+    ResampleControl* control;   // Progress and cancellation, may be 0
+};
+
+// Luminance of the rows y0 <= y < y1
+static void grayscaleRows(const FilterPass& pass, int y0, int y1) {
+    int width = pass.width;
+    for (int y = y0; y < y1; ++y) {
+        if (isCancelled(pass.control))
+            return;
+        const float* red = pass.src->row(PLANE_RED, y);
+        const float* green = pass.src->row(PLANE_GREEN, y);
+        const float* blue = pass.src->row(PLANE_BLUE, y);
+        float* dst = pass.dst->row(PLANE_RED, y);
+        for (int x = 0; x < width; ++x)
+            dst[x] = 0.2126f*red[x] + 0.7152f*green[x] + 0.0722f*blue[x];
+        memcpy(pass.dst->row(PLANE_GREEN, y), dst, width*sizeof(float));
+        memcpy(pass.dst->row(PLANE_BLUE, y), dst, width*sizeof(float));
+        addRowsDone(pass.control, 1);
+    }
+}
+
+// High-pass filter of the rows r0 <= r < r1
+static void highPassRows(const FilterPass& pass, int r0, int r1) {
+    int width = pass.width;
+    int height = pass.height;
+    double contrast = pass.contrast;
+    for (int r = r0; r < r1; ++r) {
+        if (isCancelled(pass.control))
+            return;
+        int c = r/height;
+        int y = r%height;
+        float* dst = pass.dst->row(c, y);
+        if (y == 0 || y == height - 1 || width < 3) {
+            for (int x = 0; x < width; ++x)
+                dst[x] = 0.f;
+            addRowsDone(pass.control, 1);
+            continue;
+        }
+        const float* s0 = pass.src->row(c, y - 1);
+        const float* s1 = pass.src->row(c, y);
+        const float* s2 = pass.src->row(c, y + 1);
+        dst[0] = 0.f;
+        for (int x = 1; x < width - 1; ++x) {
+            double v =
+                (9.*s1[x] - ((double) s0[x-1] + s0[x] + s0[x+1])) -
+                ((double) s2[x-1] + s2[x] + s2[x+1]) -
+                ((double) s1[x-1] + s1[x+1]);
+            dst[x] = (float) sigmoid(v, contrast);
+        }
+        dst[width - 1] = 0.f;
+        addRowsDone(pass.control, 1);
+    }
+}
+
+void grayscaleFilter(
+    const PlanarImage& image,
+    PlanarImage& gray,
+    int numThreads, /* = 0 */
+    ResampleControl* control    /* = 0 */
+) {
+    assert(&gray != &image);
+    gray.create(image.width, image.height);
+    if (image.width <= 0 || image.height <= 0)
+        return;
+    FilterPass pass;
+    pass.width = image.width;
+    pass.height = image.height;
+    pass.src = &image;
+    pass.dst = &gray;
+    pass.contrast = 1.;
+    pass.control = control;
+    addRowsTotal(control, image.height);
+    runThreadRanges(grayscaleRows, pass, 0, image.height, numThreads);
+}
+
+void highPassFilter(
+    const PlanarImage& image,
+    PlanarImage& filtered,
+    double contrast,
+    int numThreads, /* = 0 */
+    ResampleControl* control    /* = 0 */
+) {
+    assert(&filtered != &image);
+    filtered.create(image.width, image.height);
+    if (image.width <= 0 || image.height <= 0)
+        return;
+    FilterPass pass;
+    pass.width = image.width;
+    pass.height = image.height;
+    pass.src = &image;
+    pass.dst = &filtered;
+    pass.contrast = contrast;
+    pass.control = control;
+    addRowsTotal(control, NUM_PLANES*image.height);
+    runThreadRanges(
+        highPassRows, pass, 0, NUM_PLANES*image.height, numThreads
+    );
+}
@@ -0,0 +1,29 @@
+#ifndef PIXEL_FILTERS_H
+#define PIXEL_FILTERS_H
+
+#include "PlanarImage.h"
+
+class ResampleControl;
+
+// Luminance 0.2126 R + 0.7152 G + 0.0722 B of the image in all
+// planes; gray is (re)allocated with the size of image
+void grayscaleFilter(
+    const PlanarImage& image,
+    PlanarImage& gray,
+    int numThreads = 0,     // 0 -- use all processors
+    ResampleControl* control = 0    // Progress and cancellation
+);
+
+// High-pass filter: the 3x3 kernel with 9 in the center and -1
+// around it, the result is mapped to [0, 1] by sigmoid(v, contrast).
+// The border pixels of the result are 0. The planes are filtered
+// independently; filtered is (re)allocated with the size of image
+void highPassFilter(
+    const PlanarImage& image,
+    PlanarImage& filtered,
+    double contrast,
+    int numThreads = 0,     // 0 -- use all processors
+    ResampleControl* control = 0    // Progress and cancellation
+);
+
+#endif
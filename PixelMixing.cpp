@@ -0,0 +1,223 @@
+#include <cassert>
+#include <cmath>
+#include <vector>
+#include "PixelMixing.h"
+#include "ResamplePlan.h"
+#include "ResampleControl.h"
+
+// The planes are processed independently. The output rows of all
+// planes of the region are numbered together: the row r is the row
+// y0 + r % regionHeight of the plane r / regionHeight.
+// The sums over the boxes are accumulated in doubles
+struct MixingPass {
+    const ImageWindow* src;
+    int x0;                 // The region of the result
+    int y0;
+    int regionWidth;
+    int regionHeight;
+    int srcX0;              // The source columns used by the region
+    int srcX1;
+    PlanarImage* dst;
+    const ResamplePlan* planX;      // KERNEL_AREA plans of the axes
+    const ResamplePlan* planY;
+    bool integerStepX;              // Boxes of whole pixels along rows
+    ResampleControl* control;       // Progress and cancellation, may be 0
+};
+
+// Number of floats of a row summed at once
+const int MIXING_CHUNK = 64;
+
+// The sum of the pixels a <= i < b of the row, a < b, by the block
+// prefix sums (prefix[i] is the sum from the start of the block of i
+// to i); the sums of the whole blocks in between are added
+static inline double blockSum(const double* prefix, int a, int b) {
+    int blockEnd = a - a%MIXING_BLOCK + MIXING_BLOCK;
+    double before = (a%MIXING_BLOCK != 0)? prefix[a - 1] : 0.;
+    if (b <= blockEnd)
+        return prefix[b - 1] - before;
+    double v = prefix[blockEnd - 1] - before;
+    for (; blockEnd + MIXING_BLOCK < b; blockEnd += MIXING_BLOCK)
+        v += prefix[blockEnd + MIXING_BLOCK - 1];
+    return v + prefix[b - 1];
+}
+
+// Integrals of the row s (indexed by the source columns) over the boxes
+// of the output columns of the region; prefix is the buffer
+// of the prefix sums indexed in the same way. The prefix sums start
+// at the blocks of the image, not at the window, so an output pixel
+// is the same in every region
+static void mixRow(
+    const MixingPass& pass, const double* s, double* prefix, double* row
+) {
+    const ResamplePlan& plan = *pass.planX;
+    const int* taps = plan.taps.data();
+    int x0 = pass.x0;
+    int x1 = x0 + pass.regionWidth;
+
+    if (pass.integerStepX) {
+        // All coverages are 1
+        for (int x = x0; x < x1; ++x) {
+            double v = 0.;
+            for (int i = taps[2*x]; i <= taps[2*x + 1]; ++i)
+                v += s[i];
+            row[x - x0] = v;
+        }
+        return;
+    }
+
+    // srcX0 is the start of a block
+    for (int b0 = pass.srcX0; b0 < pass.srcX1; b0 += MIXING_BLOCK) {
+        int b1 = b0 + MIXING_BLOCK;
+        if (b1 > pass.srcX1)
+            b1 = pass.srcX1;
+        double p = 0.;
+        for (int i = b0; i < b1; ++i) {
+            p += s[i];
+            prefix[i] = p;
+        }
+    }
+
+    const double* weights = plan.weights.data();
+    for (int x = x0; x < x1; ++x) {
+        int i0 = taps[2*x];
+        int i1 = taps[2*x + 1];
+        double v = weights[2*x]*s[i0];
+        if (i1 > i0) {
+            v += weights[2*x + 1]*s[i1];
+            if (i1 > i0 + 1)
+                v += blockSum(prefix, i0 + 1, i1);
+        }
+        row[x - x0] = v;
+    }
+}
+
+// The output rows r0 <= r < r1. The source rows of the box are summed
+// with their coverages first (the inner loop goes along the source
+// columns of the region), then the sum is reduced along the row
+// once per output row
+static void mixRows(const MixingPass& pass, int r0, int r1) {
+    int srcX0 = pass.srcX0;
+    int srcX1 = pass.srcX1;
+    std::vector<double> column(srcX1 - srcX0);
+    std::vector<double> prefixes(srcX1 - srcX0);
+    std::vector<double> row(pass.regionWidth);
+    double* sum = column.data() - srcX0;    // Indexed by the columns
+    double* prefix = prefixes.data() - srcX0;
+
+    const ResamplePlan& planX = *pass.planX;
+    const ResamplePlan& planY = *pass.planY;
+    for (int r = r0; r < r1; ++r) {
+        if (isCancelled(pass.control))
+            return;
+        int c = r/pass.regionHeight;
+        int y = pass.y0 + r%pass.regionHeight;
+        int i0 = planY.taps[2*y];
+        int i1 = planY.taps[2*y + 1];
+        // By short chunks of the row: the chunk of the sum stays
+        // in the L1 cache while the rows of the box are read
+        double w0 = planY.weights[2*y];
+        double w1 = planY.weights[2*y + 1];
+        const float* s0 = pass.src->row(c, i0);
+        const float* s1 = pass.src->row(c, i1);
+        for (int j0 = srcX0; j0 < srcX1; j0 += MIXING_CHUNK) {
+            int j1 = j0 + MIXING_CHUNK;
+            if (j1 > srcX1)
+                j1 = srcX1;
+            if (i1 == i0) {
+                for (int j = j0; j < j1; ++j)
+                    sum[j] = w0*s0[j];
+                continue;
+            }
+            for (int j = j0; j < j1; ++j)
+                sum[j] = w0*s0[j] + w1*s1[j];
+            for (int i = i0 + 1; i < i1; ++i) {
+                const float* s = pass.src->row(c, i);
+                for (int j = j0; j < j1; ++j)
+                    sum[j] += s[j];
+            }
+        }
+        mixRow(pass, sum, prefix, row.data());
+
+        double fracY = planY.frac[y];
+        float* dst = pass.dst->row(c, y - pass.y0);
+        for (int x = 0; x < pass.regionWidth; ++x)
+            dst[x] = (float)(row[x]*planX.frac[pass.x0 + x]*fracY);
+        addRowsDone(pass.control, 1);
+    }
+}
+
+void pixelMixing(
+    const PlanarImage& image,
+    int mixedWidth, int mixedHeight,
+    PlanarImage& mixed,
+    double stepX, double stepY,
+    int numThreads, /* = 0 */
+    ResampleControl* control    /* = 0 */
+) {
+    pixelMixingRegion(
+        ImageWindow(image), mixedWidth, mixedHeight,
+        0, 0, mixedWidth, mixedHeight, mixed,
+        stepX, stepY, numThreads, control
+    );
+}
+
+void pixelMixingRegion(
+    const ImageWindow& image,
+    int mixedWidth, int mixedHeight,
+    int x0, int y0, int regionWidth, int regionHeight,
+    PlanarImage& region,
+    double stepX, double stepY,
+    int numThreads, /* = 0 */
+    ResampleControl* control    /* = 0 */
+) {
+    assert(stepX > 0. && stepY > 0.);
+    assert(&region != image.part);
+    assert(
+        0 <= x0 && x0 + regionWidth <= mixedWidth &&
+        0 <= y0 && y0 + regionHeight <= mixedHeight
+    );
+    int imageWidth = image.width;
+    int imageHeight = image.height;
+    if (
+        imageWidth <= 0 || imageHeight <= 0 ||
+        regionWidth <= 0 || regionHeight <= 0
+    )
+        return;
+    region.create(regionWidth, regionHeight);
+
+    std::shared_ptr<const ResamplePlan> planX = ResamplePlan::get(
+        KERNEL_AREA, imageWidth, mixedWidth, stepX
+    );
+    std::shared_ptr<const ResamplePlan> planY = ResamplePlan::get(
+        KERNEL_AREA, imageHeight, mixedHeight, stepY
+    );
+
+    MixingPass pass;
+    pass.src = &image;
+    pass.x0 = x0;
+    pass.y0 = y0;
+    pass.regionWidth = regionWidth;
+    pass.regionHeight = regionHeight;
+    // The boxes grow with the output column; the columns start
+    // at the block of the first box
+    pass.srcX0 = planX->taps[2*x0];
+    pass.srcX0 -= pass.srcX0%MIXING_BLOCK;
+    pass.srcX1 = planX->taps[2*(x0 + regionWidth - 1) + 1] + 1;
+    assert(
+        image.contains(
+            pass.srcX0, planY->taps[2*y0], pass.srcX1 - pass.srcX0,
+            planY->taps[2*(y0 + regionHeight - 1) + 1] + 1 -
+            planY->taps[2*y0]
+        )
+    );
+    pass.dst = &region;
+    pass.planX = planX.get();
+    pass.planY = planY.get();
+    pass.integerStepX = (stepX == floor(stepX));
+    pass.control = control;
+
+    // The output rows are divided into contiguous ranges
+    int numRows = NUM_PLANES*regionHeight;
+    addRowsTotal(control, numRows);
+    runThreadRanges(mixRows, pass, 0, numRows, numThreads);
+}
@@ -0,0 +1,50 @@
+#ifndef PIXEL_MIXING_H
+#define PIXEL_MIXING_H
+
+#include "PlanarImage.h"
+
+class ResampleControl;
+
+// The prefix sums of the rows restart at the multiples of this number
+// of source columns: a box is summed in the same way in every window
+// of the source that contains the blocks of its columns
+const int MIXING_BLOCK = 64;
+
+// Area averaging ("pixel mixing"): the output pixel (x, y) is the mean
+// of the source image over the box
+//     [x*stepX, (x+1)*stepX) x [y*stepY, (y+1)*stepY)
+// (clipped at the borders of the image), every source pixel is weighted
+// by the area covered by the box.
+// The source rows of a box are summed with their coverages, then
+// the sum is reduced along the row with the prefix sums that restart
+// at every MIXING_BLOCK columns of the image, so the work per output
+// pixel is the number of blocks its box crosses; when stepX
+// is integer, the boxes of the row are summed directly.
+// The planes are processed independently; mixed is (re)allocated
+// with the size mixedWidth x mixedHeight
+void pixelMixing(
+    const PlanarImage& image,
+    int mixedWidth, int mixedHeight,
+    PlanarImage& mixed,
+    double stepX, double stepY,     // Box size in source pixels
+    int numThreads = 0,             // 0 -- use all processors
+    ResampleControl* control = 0    // Progress and cancellation
+);
+
+// The part x0 <= x < x0 + regionWidth, y0 <= y < y0 + regionHeight
+// of the result of pixelMixing of the whole image with the same
+// parameters, the pixels are the same as in the whole result; region
+// is (re)allocated with the size regionWidth x regionHeight.
+// Only the source pixels of the boxes of the region are read, from
+// the start of the block of MIXING_BLOCK columns of the first box
+void pixelMixingRegion(
+    const ImageWindow& image,
+    int mixedWidth, int mixedHeight,
+    int x0, int y0, int regionWidth, int regionHeight,
+    PlanarImage& region,
+    double stepX, double stepY,
+    int numThreads = 0,
+    ResampleControl* control = 0
+);
+
+#endif
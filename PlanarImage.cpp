@@ -0,0 +1,104 @@
+#include <cassert>
+#include <cstring>
+#include <utility>
+#include "PlanarImage.h"
+
+int planarStride(int w) {
+    const int floatsPerBlock = PLANAR_ALIGNMENT/(int) sizeof(float);
+    return (w + floatsPerBlock - 1)/floatsPerBlock*floatsPerBlock;
+}
+
+PlanarImage::PlanarImage():
+    width(0),
+    height(0),
+    stride(0),
+    memory(0),
+    capacity(0)
+{
+    for (int c = 0; c < NUM_PLANES; ++c)
+        planes[c] = 0;
+}
+
+PlanarImage::PlanarImage(int w, int h):
+    width(0),
+    height(0),
+    stride(0),
+    memory(0),
+    capacity(0)
+{
+    for (int c = 0; c < NUM_PLANES; ++c)
+        planes[c] = 0;
+    create(w, h);
+}
+
+PlanarImage::~PlanarImage() {
+    delete[] memory;
+}
+
+void PlanarImage::create(int w, int h) {
+    assert(w >= 0 && h >= 0);
+    width = w;
+    height = h;
+    stride = planarStride(w);
+    size_t planeSize = (size_t) stride*(size_t) h;
+    size_t needed = (size_t) NUM_PLANES*planeSize*sizeof(float) +
+        PLANAR_ALIGNMENT;
+    if (memory == 0 || needed > capacity) {
+        delete[] memory;
+        memory = new char[needed];
+        capacity = needed;
+    }
+
+    // The planes follow each other, the size of a plane is a multiple
+    // of the alignment, so all rows are aligned
+    size_t offset = (size_t) memory % PLANAR_ALIGNMENT;
+    float* p = (float*)(
+        memory + ((offset == 0)? 0 : PLANAR_ALIGNMENT - offset)
+    );
+    for (int c = 0; c < NUM_PLANES; ++c)
+        planes[c] = p + c*planeSize;
+}
+
+void PlanarImage::release() {
+    delete[] memory;
+    memory = 0;
+    capacity = 0;
+    width = 0;
+    height = 0;
+    stride = 0;
+    for (int c = 0; c < NUM_PLANES; ++c)
+        planes[c] = 0;
+}
+
+void PlanarImage::fill(float value) {
+    size_t planeSize = (size_t) stride*(size_t) height;
+    for (int c = 0; c < NUM_PLANES; ++c) {
+        float* p = planes[c];
+        for (size_t i = 0; i < planeSize; ++i)
+            p[i] = value;
+    }
+}
+
+void PlanarImage::copyFrom(const PlanarImage& image) {
+    if (&image == this)
+        return;
+    if (image.isNull()) {
+        release();
+        return;
+    }
+    create(image.width, image.height);
+    assert(stride == image.stride);
+    size_t planeSize = (size_t) stride*(size_t) height*sizeof(float);
+    for (int c = 0; c < NUM_PLANES; ++c)
+        memcpy(planes[c], image.planes[c], planeSize);
+}
+
+void PlanarImage::swap(PlanarImage& image) {
+    std::swap(width, image.width);
+    std::swap(height, image.height);
+    std::swap(stride, image.stride);
+    for (int c = 0; c < NUM_PLANES; ++c)
+        std::swap(planes[c], image.planes[c]);
+    std::swap(memory, image.memory);
+    std::swap(capacity, image.capacity);
+}
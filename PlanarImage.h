@@ -0,0 +1,132 @@
+#ifndef PLANAR_IMAGE_H
+#define PLANAR_IMAGE_H
+
+#include <cstddef>
+#include "RealPixel.h"
+
+// Rows of the planes start at this boundary (in bytes)
+const int PLANAR_ALIGNMENT = 32;
+
+// Channels of the planar image
+enum PlanarChannel {
+    PLANE_RED = 0,
+    PLANE_GREEN = 1,
+    PLANE_BLUE = 2,
+    NUM_PLANES = 3
+};
+
+// Working image of the filters and resamplers: 3 planes of floats
+// (red, green, blue, values in [0, 1]) in one memory block.
+// The pixel (x, y) of the plane c is
+//     planes[c][y*stride + x],
+// stride is the row length rounded up so that every row starts
+// at PLANAR_ALIGNMENT bytes. A pixel takes 12 bytes instead of
+// 24 bytes of RealPixel, and the loops along rows of a plane are
+// vectorized by the compiler.
+// The image owns its memory and is not copyable; use copyFrom or swap
+class PlanarImage {
+public:
+    int width;
+    int height;
+    int stride;             // Floats between adjacent rows of a plane
+    float* planes[NUM_PLANES];
+
+    PlanarImage();
+    PlanarImage(int w, int h);
+    ~PlanarImage();
+
+    // Allocate the planes of w*h pixels, the contents are undefined.
+    // The memory is reused when the size of planes does not grow
+    void create(int w, int h);
+    void release();
+    bool isNull() const { return memory == 0; }
+
+    float* row(int c, int y) {
+        return planes[c] + (size_t) y*(size_t) stride;
+    }
+    const float* row(int c, int y) const {
+        return planes[c] + (size_t) y*(size_t) stride;
+    }
+
+    RealPixel pixel(int x, int y) const {
+        size_t i = (size_t) y*(size_t) stride + (size_t) x;
+        return RealPixel(
+            (double) planes[PLANE_RED][i],
+            (double) planes[PLANE_GREEN][i],
+            (double) planes[PLANE_BLUE][i]
+        );
+    }
+    void setPixel(int x, int y, const RealPixel& p) {
+        size_t i = (size_t) y*(size_t) stride + (size_t) x;
+        planes[PLANE_RED][i] = (float) p.red();
+        planes[PLANE_GREEN][i] = (float) p.green();
+        planes[PLANE_BLUE][i] = (float) p.blue();
+    }
+    void setPixel(int x, int y, float r, float g, float b) {
+        size_t i = (size_t) y*(size_t) stride + (size_t) x;
+        planes[PLANE_RED][i] = r;
+        planes[PLANE_GREEN][i] = g;
+        planes[PLANE_BLUE][i] = b;
+    }
+
+    void fill(float value);
+    void copyFrom(const PlanarImage& image);
+    void swap(PlanarImage& image);
+
+    // Memory of the planes in bytes
+    size_t size() const {
+        return (size_t) NUM_PLANES*(size_t) stride*(size_t) height*
+            sizeof(float);
+    }
+
+private:
+    char* memory;           // Allocated block, planes[0] is aligned in it
+    size_t capacity;        // Size of the block
+
+    PlanarImage(const PlanarImage&);
+    PlanarImage& operator=(const PlanarImage&);
+};
+
+// Stride of rows of w floats
+int planarStride(int w);
+
+// Source of the ...Region functions of the engines: a part of a larger
+// image. The pixel (x, y) of the whole image of width x height pixels
+// is the pixel (x - x0, y - y0) of part. The region functions read
+// only the source pixels their region depends on, so part has to hold
+// only them (see resampleRegionSource of Resampler.h)
+struct ImageWindow {
+    const PlanarImage* part;
+    int x0;                 // Position of part in the whole image
+    int y0;
+    int width;              // Size of the whole image
+    int height;
+
+    // The whole image
+    explicit ImageWindow(const PlanarImage& image):
+        part(&image), x0(0), y0(0),
+        width(image.width), height(image.height)
+    {}
+    ImageWindow(
+        const PlanarImage& p, int px0, int py0, int w, int h
+    ):
+        part(&p), x0(px0), y0(py0), width(w), height(h)
+    {}
+
+    // The row y of the whole image indexed by the columns of the whole
+    // image; only the columns x0 <= x < x0 + part->width may be read
+    const float* row(int c, int y) const {
+        return part->row(c, y - y0) - x0;
+    }
+    int stride() const { return part->stride; }
+
+    // True if the rectangle of the whole image is inside part
+    bool contains(int rx, int ry, int w, int h) const {
+        return (
+            rx >= x0 && ry >= y0 &&
+            rx + w <= x0 + part->width && ry + h <= y0 + part->height
+        );
+    }
+};
+
+#endif
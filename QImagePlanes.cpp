@@ -0,0 +1,47 @@
+#include "QImagePlanes.h"
+#include "ImageConvert.h"
+
+void imageToPlanes(
+    const QImage& image, PlanarImage& planes,
+    int numThreads  /* = 0 */
+) {
+    int layout;
+    switch (image.format()) {
+    case QImage::Format_RGB32:
+    case QImage::Format_ARGB32:
+        layout = PIXELS_XRGB32;
+        break;
+    case QImage::Format_RGB888:
+        layout = PIXELS_RGB888;
+        break;
+    case QImage::Format_Grayscale8:
+        layout = PIXELS_GRAY8;
+        break;
+    default: {
+            QImage rgbImage = image.convertToFormat(QImage::Format_RGB32);
+            importPixels(
+                rgbImage.width(), rgbImage.height(),
+                rgbImage.constBits(), rgbImage.bytesPerLine(),
+                PIXELS_XRGB32, planes, numThreads
+            );
+            return;
+        }
+    }
+    importPixels(
+        image.width(), image.height(),
+        image.constBits(), image.bytesPerLine(),
+        layout, planes, numThreads
+    );
+}
+
+QImage planesToImage(
+    const PlanarImage& planes,
+    int numThreads  /* = 0 */
+) {
+    QImage image(planes.width, planes.height, QImage::Format_RGB32);
+    exportPixels(
+        planes, image.bits(), image.bytesPerLine(), PIXELS_XRGB32,
+        numThreads
+    );
+    return image;
+}
@@ -0,0 +1,22 @@
+#ifndef QIMAGE_PLANES_H
+#define QIMAGE_PLANES_H
+
+#include <QImage>
+#include "PlanarImage.h"
+
+// Conversion of QImage to the planes and back by the bulk converters
+// of ImageConvert.h. The scanlines of RGB32, ARGB32, RGB888 and
+// Grayscale8 images are read directly, the other formats are converted
+// to RGB32 first; planes is (re)allocated with the size of image
+void imageToPlanes(
+    const QImage& image, PlanarImage& planes,
+    int numThreads = 0      // 0 -- use all processors
+);
+
+// The RGB32 image of the planes (the values are rounded and clamped)
+QImage planesToImage(
+    const PlanarImage& planes,
+    int numThreads = 0      // 0 -- use all processors
+);
+
+#endif
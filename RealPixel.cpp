@@ -1,135 +1,796 @@
+#include <cassert>
+#include <cmath>
+#include <thread>
+#include <vector>
 #include "RealPixel.h"
+#include "PlanarImage.h"
+#include "ResamplePlan.h"
+#include "ResampleControl.h"
 #include "CubicInterpol/cubint.h"
+#include "CubicInterpol/vectorspline.h"
+#include "CubicInterpol/bspline.h"
 
-static inline double restrict01(double v) {
-    if (v < 0.)
-        return 0.;
-    else if (v > 1.)
-        return 1.;
-    else
-        return v;
-}
+typedef VectorSpline<3> RGBSpline;     // Red, green, blue channels
 
-void splineInterpolation(
-    int imageWidth, int imageHeight,
-    const RealPixel* imageMatrix,
-    double zoom,
-    double& realZoomX, double& realZoomY,
-    int& zoomedWidth, int& zoomedHeight,
-    RealPixel** zoomedMatrix,
-    int splineType /* = 0 */    // 0 -- C2-cubic spline, 1 -- C1-spline
+// The windowed solve of C2-splines: the segments of a line are divided
+// into chunks of SPLINE_C2_CHUNK segments, and the spline of a chunk
+// is solved on the window of its nodes and the halo of nodes on both
+// sides. A chunk is computed in the same way for any part of the line,
+// so the parts join without seams; the halo bounds the difference
+// from the spline of the whole line (see splineC2Halo)
+const int SPLINE_C2_CHUNK = 64;
+
+// The influence of a node on the C2-spline with equal steps decays
+// as (2 - sqrt(3))^k with the distance of k nodes
+const double SPLINE_C2_DECAY = 0.2679491924311227;
+
+// The bound of the error of the values in [0, 1] caused by
+// the windowed solve is SPLINE_C2_ERROR*SPLINE_C2_DECAY^halo: the second
+// derivatives in nodes are at most 6 (the unit step), the error
+// of a derivative at the end of the window decays inside, and that
+// of the rows is interpolated again by the columns
+const double SPLINE_C2_ERROR = 4.;
+
+// The largest halo, the error is then below 1e-14
+const int SPLINE_C2_MAX_HALO = 25;
+
+// The part of a line solved together: the window of numNodes nodes
+// from firstNode gives the numSamples samples from firstSample,
+// factorized holds its abscissas and the factorization of C2 system,
+// splineType is the type of the pass or the fallback of the piece
+// whose C2 system failed to factorize
+struct SplinePiece {
+    int firstNode;
+    int numNodes;
+    int firstSample;
+    int numSamples;
+    int splineType;
+    const RGBSpline* factorized;
+};
+
+// One pass of spline interpolation: every line of the source image
+// (a row or a column) is interpolated by the splines and evaluated
+// at the points with unit step.
+// A line has totalNodes nodes and totalSamples samples; the pass may
+// use the window of numNodes nodes from firstNode and compute
+// the numSamples samples from firstSample (the window must contain
+// all nodes the polynomials of these samples depend on), the samples
+// are the same as for the whole line.
+// The pixel j of the window of line i is
+// src[c][i*srcLineStep + j*srcNodeStep], the sample firstSample + k
+// of line i is dst[c][i*dstLineStep + k*dstSampleStep] in the planes
+// c = 0, 1, 2 (the steps are in floats).
+// The window is solved entirely, or by the chunks if c2Halo > 0.
+// The lines are processed by blocks of blockSize adjacent lines:
+// for the columns pass (srcLineStep == dstLineStep == 1) the nodes
+// are gathered and the samples are stored along the rows of planes,
+// not along the columns
+struct SplinePass {
+    const float* src[NUM_PLANES];
+    int srcLineStep;
+    int srcNodeStep;
+    int totalNodes;
+    int firstNode;
+    int numNodes;
+    double nodeStep;        // Distance between nodes in output pixels
+
+    float* dst[NUM_PLANES];
+    int dstLineStep;
+    int dstSampleStep;
+    int totalSamples;
+    int firstSample;
+    int numSamples;
+
+    const int* segments;    // Segment of the line for every sample
+    int blockSize;          // Number of lines processed together
+    int splineType;
+    bool restrictValues;    // Restrict the result to [0, 1]
+    int c2Halo;             // C2-splines: nodes around the chunks,
+                            // 0 -- the whole window is solved
+    const SplinePiece* pieces;  // The window by pieces, common
+    int numPieces;              // for all lines
+    int integerZoom;        // 2, 3 or 4 if nodeStep is this integer,
+                            // otherwise 0
+    ResampleControl* control;   // Progress and cancellation, may be 0
+};
+
+// Number of adjacent columns interpolated together:
+// 16 floats of a plane are one cache line
+const int SPLINE_COLUMN_BLOCK = 16;
+
+// Forward differences are used when the distance between nodes
+// is at least SPLINE_FD_MIN_STEP output pixels; every SPLINE_FD_PERIOD
+// samples they are recomputed exactly to bound the accumulated error
+const double SPLINE_FD_MIN_STEP = 4.;
+const int SPLINE_FD_PERIOD = 16;
+
+// Store the sample with the offset q in the planes
+static inline void storeSample(
+    float* const* dst, ptrdiff_t q, double* v, bool restrictValues
 ) {
-    zoomedWidth = (int)(imageWidth*zoom + 0.49);
-    zoomedHeight = (int)(imageHeight*zoom + 0.49);
-    realZoomX = (double) zoomedWidth / (double) imageWidth;
-    realZoomY = (double) zoomedHeight / (double) imageHeight;
+    if (restrictValues) {
+        v[0] = restrict01(v[0]);
+        v[1] = restrict01(v[1]);
+        v[2] = restrict01(v[2]);
+    }
+    dst[0][q] = (float) v[0];
+    dst[1][q] = (float) v[1];
+    dst[2][q] = (float) v[2];
+}
 
-    RealPixel* zoomedMatrX = new RealPixel[zoomedWidth*imageHeight];
-    CubicSpline redSpline(imageWidth);
-    CubicSpline greenSpline(imageWidth);
-    CubicSpline blueSpline(imageWidth);
-    double dx = realZoomX;
-    for (int y = 0; y < imageHeight; ++y) {
-        int nodeIdx;
-        double nodeX = 0.;
-        for (nodeIdx = 0; nodeIdx < imageWidth; ++nodeIdx) {
-            redSpline.nodes[nodeIdx].x = nodeX;
-            greenSpline.nodes[nodeIdx].x = nodeX;
-            blueSpline.nodes[nodeIdx].x = nodeX;
-
-            RealPixel p = imageMatrix[y*imageWidth + nodeIdx];
-            redSpline.nodes[nodeIdx].y = p.red();
-            greenSpline.nodes[nodeIdx].y = p.green();
-            blueSpline.nodes[nodeIdx].y = p.blue();
-            nodeX += dx; 
+// Local coordinate of the phase k of the integer zoom z
+static constexpr double zoomPhase(int k, int z) {
+    return (double) k / (double) z;
+}
+
+// Powers of the local coordinates (k + shift)/Z of the phases k
+template <int Z>
+struct ZoomPhases {
+    double t[Z];
+    double t2[Z];
+    double t3[Z];
+
+    explicit ZoomPhases(int shift) {
+        for (int k = 0; k < Z; ++k) {
+            t[k] = zoomPhase(k + shift, Z);
+            t2[k] = t[k]*t[k];
+            t3[k] = t2[k]*t[k];
         }
-        if (splineType == 0) {
-            redSpline.interpolateC2();
-            greenSpline.interpolateC2();
-            blueSpline.interpolateC2();
-        } else {
-            redSpline.interpolateC1();
-            greenSpline.interpolateC1();
-            blueSpline.interpolateC1();
+    }
+};
+
+// Samples of a segment for the integer zoom Z, the loop over
+// the phases has the constant length; q is the offset of the phase 0.
+// The partial segments at the ends of a window compute
+// the phases k0 <= k < k1
+template <int Z>
+static inline void splinePhases(
+    const ZoomPhases<Z>& phases, const CubicPolynomial* p,
+    float* const* dst, ptrdiff_t q, int step, bool restrictValues,
+    int k0 = 0, int k1 = Z
+) {
+    const double* a = p[0].coeff;
+    const double* b = p[1].coeff;
+    const double* c = p[2].coeff;
+    q += (ptrdiff_t) k0*step;
+    for (int k = k0; k < k1; ++k) {
+        double v[3];
+        v[0] = a[0] + a[1]*phases.t[k] + a[2]*phases.t2[k] +
+            a[3]*phases.t3[k];
+        v[1] = b[0] + b[1]*phases.t[k] + b[2]*phases.t2[k] +
+            b[3]*phases.t3[k];
+        v[2] = c[0] + c[1]*phases.t[k] + c[2]*phases.t2[k] +
+            c[3]*phases.t3[k];
+        storeSample(dst, q, v, restrictValues);
+        q += step;
+    }
+}
+
+// The samples of the lines for the integer zoom Z: the segment s
+// of the line gives the samples s*Z .. s*Z + Z-1, the last segment
+// also gives the Z samples after the last node
+template <int Z>
+static void splineSamplesZoom(
+    const SplinePass& pass, const SplinePiece& piece,
+    const RGBSpline* splines, int numLines, ptrdiff_t dst
+) {
+    const ZoomPhases<Z> inner(0);
+    const ZoomPhases<Z> outer(Z);
+    int lastSegment = piece.numNodes - 2;   // In the window
+    int step = pass.dstSampleStep;
+    int j0 = piece.firstSample;
+    int j1 = j0 + piece.numSamples;
+    for (int i = 0; i < numLines; ++i) {
+        const CubicPolynomial* p = splines[i].polynomials;
+        ptrdiff_t line = dst + (ptrdiff_t) i*pass.dstLineStep;
+        // j is the first sample of the segment
+        for (int j = j0 - j0%Z; j < j1; j += Z) {
+            int seg = j/Z - piece.firstNode;
+            const ZoomPhases<Z>* phases = &inner;
+            if (seg > lastSegment) {
+                seg = lastSegment;
+                phases = &outer;
+            }
+            ptrdiff_t q = line + (ptrdiff_t)(j - j0)*step;
+            if (j >= j0 && j + Z <= j1) {
+                splinePhases<Z>(
+                    *phases, p + seg*3, pass.dst, q, step,
+                    pass.restrictValues
+                );
+            } else {
+                splinePhases<Z>(
+                    *phases, p + seg*3, pass.dst, q, step,
+                    pass.restrictValues,
+                    (j < j0)? j0 - j : 0, (j + Z > j1)? j1 - j : Z
+                );
+            }
         }
+    }
+}
 
-        nodeIdx = 0;
-        for (int x = 0; x < zoomedWidth; ++x) {
+// The abscissas of the nodes 0, 1, ..., numNodes - 1 of the line,
+// accumulated in the same way for every window
+static void lineAbscissas(
+    double nodeStep, int numNodes, std::vector<double>& nodeX
+) {
+    nodeX.resize(numNodes);
+    double x = 0.;
+    for (int nodeIdx = 0; nodeIdx < numNodes; ++nodeIdx) {
+        nodeX[nodeIdx] = x;
+        x += nodeStep;
+    }
+}
+
+// The nodes firstNode <= i <= lastNode of the window of the chunk
+// of a line of numNodes nodes
+static void c2ChunkNodes(
+    int chunk, int halo, int numNodes, int& firstNode, int& lastNode
+) {
+    firstNode = chunk*SPLINE_C2_CHUNK - halo;
+    lastNode = (chunk + 1)*SPLINE_C2_CHUNK + halo;
+    if (firstNode < 0)
+        firstNode = 0;
+    if (lastNode > numNodes - 1)
+        lastNode = numNodes - 1;
+}
+
+// The samples of the piece of numLines lines of the block with
+// the solved splines, dst is the offset of the first sample
+// of the piece in the first line
+static void splineSamples(
+    const SplinePass& pass, const SplinePiece& piece,
+    RGBSpline* splines, int numLines, ptrdiff_t dst
+) {
+    int nodeIdx;
+    if (pass.integerZoom == 2) {
+        splineSamplesZoom<2>(pass, piece, splines, numLines, dst);
+        return;
+    } else if (pass.integerZoom == 3) {
+        splineSamplesZoom<3>(pass, piece, splines, numLines, dst);
+        return;
+    } else if (pass.integerZoom == 4) {
+        splineSamplesZoom<4>(pass, piece, splines, numLines, dst);
+        return;
+    }
+
+    int x0 = piece.firstSample;
+    int x1 = x0 + piece.numSamples;
+    if (pass.nodeStep < SPLINE_FD_MIN_STEP) {
+        for (int x = x0; x < x1; ++x) {
             double xx = (double) x;
-            while (
-                nodeIdx < imageWidth-2 &&
-                xx >= redSpline.nodes[nodeIdx+1].x
-            )
-                ++nodeIdx;
-
-            double v = redSpline.value(
-                xx, nodeIdx
-            );
-            zoomedMatrX[y*zoomedWidth + x].setRed(v);
-            v = greenSpline.value(
-                xx, nodeIdx
+            nodeIdx = pass.segments[x] - piece.firstNode;
+
+            ptrdiff_t q = dst + (ptrdiff_t)(x - x0)*pass.dstSampleStep;
+            for (int i = 0; i < numLines; ++i) {
+                double v[3];
+                splines[i].value(xx, nodeIdx, v);
+                storeSample(pass.dst, q, v, pass.restrictValues);
+                q += pass.dstLineStep;
+            }
+        }
+        return;
+    }
+
+    // Large zoom: the samples of a segment are computed by
+    // forward differences (3 additions per sample and channel).
+    // The polynomials of all spline types are in the local coordinates
+    // of segments, so the differences are well conditioned.
+    // The run is restarted from the exact values at the beginning
+    // of every segment and every SPLINE_FD_PERIOD samples; a window
+    // starts with the run of the whole line that contains x0,
+    // so the samples are the same.
+    // As in the loop above, the lines of the block are inner:
+    // the column pass stores the samples along the rows
+    assert(numLines <= SPLINE_COLUMN_BLOCK);
+    double diffs[SPLINE_COLUMN_BLOCK*12];   // 3 channels x 4 differences
+                                            // of every line
+    int x = x0;
+    int segmentStart = x0;
+    while (
+        segmentStart > 0 &&
+        pass.segments[segmentStart - 1] == pass.segments[x0]
+    )
+        --segmentStart;
+    x -= (x0 - segmentStart)%SPLINE_FD_PERIOD;
+    while (x < x1) {
+        nodeIdx = pass.segments[x];
+        int runEnd = x + 1;
+        while (
+            runEnd < x1 &&
+            runEnd - x < SPLINE_FD_PERIOD &&
+            pass.segments[runEnd] == nodeIdx
+        )
+            ++runEnd;
+        nodeIdx -= piece.firstNode;
+
+        for (int i = 0; i < numLines; ++i) {
+            splines[i].forwardDifferences(
+                (double) x, 1., nodeIdx, diffs + 12*i
             );
-            zoomedMatrX[y*zoomedWidth + x].setGreen(v);
-            v = blueSpline.value(
-                xx, nodeIdx
+        }
+        ptrdiff_t q = dst + (ptrdiff_t)(x - x0)*pass.dstSampleStep;
+        for (int k = x; k < runEnd; ++k) {
+            ptrdiff_t p = q;
+            for (int i = 0; i < numLines; ++i) {
+                double* d = diffs + 12*i;
+                if (k >= x0) {
+                    double v[3] = {d[0], d[4], d[8]};
+                    storeSample(pass.dst, p, v, pass.restrictValues);
+                }
+                d[0] += d[1]; d[1] += d[2]; d[2] += d[3];
+                d[4] += d[5]; d[5] += d[6]; d[6] += d[7];
+                d[8] += d[9]; d[9] += d[10]; d[10] += d[11];
+                p += pass.dstLineStep;
+            }
+            q += pass.dstSampleStep;
+        }
+        x = runEnd;
+    }
+}
+
+// Interpolate the lines line0 <= i < line1 of the pass.
+// Every call uses its own splines, so the calls for different
+// lines can run in parallel
+static void splinePassLines(const SplinePass& pass, int line0, int line1) {
+    int blockSize = pass.blockSize;
+
+    // RGB spline for every line of the block, the nodes
+    // of the current piece
+    RGBSpline* splines = new RGBSpline[blockSize];
+    const SplinePiece* current = 0;
+
+    for (int block = line0; block < line1; block += blockSize) {
+        if (isCancelled(pass.control))
+            break;
+        int numLines = line1 - block;
+        if (numLines > blockSize)
+            numLines = blockSize;
+
+        const float* red = pass.src[PLANE_RED];
+        const float* green = pass.src[PLANE_GREEN];
+        const float* blue = pass.src[PLANE_BLUE];
+        for (int k = 0; k < pass.numPieces; ++k) {
+            const SplinePiece& piece = pass.pieces[k];
+            int numNodes = piece.numNodes;
+            if (current != &piece) {
+                for (int i = 0; i < blockSize; ++i) {
+                    splines[i].resize(numNodes);
+                    for (int nodeIdx = 0; nodeIdx < numNodes; ++nodeIdx)
+                        splines[i].x[nodeIdx] = piece.factorized->x[nodeIdx];
+                }
+                current = &piece;
+            }
+
+            ptrdiff_t src = (ptrdiff_t) block*pass.srcLineStep +
+                (ptrdiff_t)(piece.firstNode - pass.firstNode)*
+                pass.srcNodeStep;
+            int nodeIdx;
+            for (nodeIdx = 0; nodeIdx < numNodes; ++nodeIdx) {
+                ptrdiff_t p = src + (ptrdiff_t) nodeIdx*pass.srcNodeStep;
+                for (int i = 0; i < numLines; ++i) {
+                    double* v = splines[i].values + nodeIdx*3;
+                    v[0] = (double) red[p];
+                    v[1] = (double) green[p];
+                    v[2] = (double) blue[p];
+                    p += pass.srcLineStep;
+                }
+            }
+            for (int i = 0; i < numLines; ++i) {
+                if (piece.splineType == 0)
+                    splines[i].solveC2(piece.factorized);
+                else if (piece.splineType == 2)
+                    splines[i].solveC2Moments(piece.factorized);
+                else
+                    splines[i].interpolateC1();
+            }
+
+            splineSamples(
+                pass, piece, splines, numLines,
+                (ptrdiff_t) block*pass.dstLineStep +
+                (ptrdiff_t)(piece.firstSample - pass.firstSample)*
+                pass.dstSampleStep
             );
-            zoomedMatrX[y*zoomedWidth + x].setBlue(v);
         }
-    } // end for (y...
+        addRowsDone(pass.control, numLines);
+    }
+    delete[] splines;
+}
 
-    RealPixel* zoomedMatrY = new RealPixel[zoomedWidth*zoomedHeight];
-    redSpline.resize(imageHeight);
-    greenSpline.resize(imageHeight);
-    blueSpline.resize(imageHeight);
-    double dy = realZoomY;
+// Divide the window of the pass into the pieces solved together:
+// the whole window, or the chunks of the samples for the windowed
+// C2 solve
+static void splinePieces(
+    const SplinePass& pass, std::vector<SplinePiece>& pieces
+) {
+    pieces.clear();
+    SplinePiece piece;
+    piece.splineType = pass.splineType;
+    piece.factorized = 0;
+    if (pass.splineType == 1 || pass.c2Halo <= 0) {
+        piece.firstNode = pass.firstNode;
+        piece.numNodes = pass.numNodes;
+        piece.firstSample = pass.firstSample;
+        piece.numSamples = pass.numSamples;
+        pieces.push_back(piece);
+        return;
+    }
+    int x1 = pass.firstSample + pass.numSamples;
+    int x = pass.firstSample;
+    while (x < x1) {
+        int chunk = pass.segments[x]/SPLINE_C2_CHUNK;
+        int end = x + 1;
+        while (end < x1 && pass.segments[end]/SPLINE_C2_CHUNK == chunk)
+            ++end;
+        int lastNode;
+        c2ChunkNodes(
+            chunk, pass.c2Halo, pass.totalNodes, piece.firstNode, lastNode
+        );
+        assert(
+            pass.firstNode <= piece.firstNode &&
+            lastNode < pass.firstNode + pass.numNodes
+        );
+        piece.numNodes = lastNode - piece.firstNode + 1;
+        piece.firstSample = x;
+        piece.numSamples = end - x;
+        pieces.push_back(piece);
+        x = end;
+    }
+}
+
+// Run the pass over numLines lines in numThreads threads.
+// The blocks of lines are divided into contiguous ranges; each line
+// is computed in the same way as in one thread, so the result does not
+// depend on the number of threads
+static void runSplinePass(SplinePass& pass, int numLines, int numThreads) {
+    // The segments of samples, common for all lines
+    std::shared_ptr<const ResamplePlan> plan = ResamplePlan::get(
+        KERNEL_SPLINE, pass.totalNodes, pass.totalSamples, pass.nodeStep
+    );
+    pass.segments = plan->first.data();
+
+    // Abscissas of nodes are the same for all lines,
+    // so the C2 system of a piece is factorized only once per pass
+    std::vector<SplinePiece> pieces;
+    splinePieces(pass, pieces);
+    std::vector<double> nodeX;
+    lineAbscissas(pass.nodeStep, pass.firstNode + pass.numNodes, nodeX);
+    RGBSpline* factorized = new RGBSpline[pieces.size()];
+    for (size_t k = 0; k < pieces.size(); ++k) {
+        RGBSpline& spline = factorized[k];
+        spline.resize(pieces[k].numNodes);
+        for (int nodeIdx = 0; nodeIdx < spline.numNodes; ++nodeIdx)
+            spline.x[nodeIdx] = nodeX[pieces[k].firstNode + nodeIdx];
+        // The band system that fails to factorize falls back to
+        // the moments (the same natural spline), and they to C1-spline
+        int& splineType = pieces[k].splineType;
+        if (splineType == 0 && !spline.factorizeC2())
+            splineType = 2;
+        if (splineType == 2 && !spline.factorizeC2Moments())
+            splineType = 1;
+        pieces[k].factorized = &spline;
+    }
+    pass.pieces = pieces.data();
+    pass.numPieces = (int) pieces.size();
+
+    // The fast path of integer zoom: the polynomials of all spline
+    // types are in the local coordinates of segments
+    pass.integerZoom = 0;
+    int zoom = (int) pass.nodeStep;
+    if (
+        pass.numNodes >= 2 &&
+        zoom >= 2 && zoom <= 4 && pass.nodeStep == (double) zoom &&
+        pass.totalSamples == zoom*pass.totalNodes
+    )
+        pass.integerZoom = zoom;
+
+    runThreadRanges(
+        splinePassLines, pass, 0, numLines, numThreads, pass.blockSize
+    );
+    pass.pieces = 0;
+    pass.numPieces = 0;
+    delete[] factorized;
+}
+
+int defaultNumThreads() {
+    int n = (int) std::thread::hardware_concurrency();
+    if (n <= 0)
+        n = 1;
+    return n;
+}
+
+// The window of nodes of a line that the samples s0 <= j < s1 depend
+// on: the polynomial of a segment of C1-spline depends on the slopes
+// in its ends, the slope in a node depends on the adjacent nodes,
+// so 1 node before the first segment and 2 nodes after the last one
+// are enough. C2-splines are global, the window is the whole line;
+// with the windowed solve (c2Halo > 0) it is the union of the windows
+// of the chunks
+static void splineWindow(
+    const ResamplePlan& plan, int splineType, int c2Halo, int s0, int s1,
+    int& firstNode, int& numNodes
+) {
+    int n = plan.srcSize;
+    if (splineType != 1 && c2Halo > 0) {
+        int firstChunk = plan.first[s0]/SPLINE_C2_CHUNK;
+        int lastChunk = plan.first[s1 - 1]/SPLINE_C2_CHUNK;
+        int a0, b0, a1, b1;
+        c2ChunkNodes(firstChunk, c2Halo, n, a0, b0);
+        c2ChunkNodes(lastChunk, c2Halo, n, a1, b1);
+        firstNode = a0;
+        numNodes = b1 - a0 + 1;
+        return;
+    }
+    if (splineType != 1) {
+        firstNode = 0;
+        numNodes = n;
+        return;
+    }
+    int a = plan.first[s0] - 1;
+    int b = plan.first[s1 - 1] + 2;
+    if (a < 0)
+        a = 0;
+    if (b > n - 1)
+        b = n - 1;
+    firstNode = a;
+    numNodes = b - a + 1;
+}
+
+// The geometry of the result of splineInterpolation
+static void splineZoomedSize(
+    int imageWidth, int imageHeight, double zoom,
+    int& zoomedWidth, int& zoomedHeight
+) {
+    zoomedWidth = (int)(imageWidth*zoom + 0.49);
+    zoomedHeight = (int)(imageHeight*zoom + 0.49);
+}
+
+void splineInterpolation(
+    const PlanarImage& image,
+    double zoom,
+    double& realZoomX, double& realZoomY,
+    PlanarImage& zoomed,
+    int splineType, /* = 0 */   // 0 -- C2-cubic spline, 1 -- C1-spline,
+                                // 2 -- C2-spline through second derivatives
+    int c2Halo,     /* = 0 */   // 0 -- the exact C2-splines
+    int numThreads, /* = 0 */   // 0 -- all processors
+    ResampleControl* control    /* = 0 */
+) {
+    int imageWidth = image.width;
+    int imageHeight = image.height;
+    int zoomedWidth, zoomedHeight;
+    splineZoomedSize(
+        imageWidth, imageHeight, zoom, zoomedWidth, zoomedHeight
+    );
+    realZoomX = (double) zoomedWidth / (double) imageWidth;
+    realZoomY = (double) zoomedHeight / (double) imageHeight;
+    splineRegion(
+        ImageWindow(image), zoom, 0, 0, zoomedWidth, zoomedHeight, zoomed,
+        splineType, c2Halo, numThreads, control
+    );
+}
+
+int splineC2Halo(double tolerance) {
+    int halo = 1;
+    double error = SPLINE_C2_ERROR*SPLINE_C2_DECAY;
+    while (error > tolerance && halo < SPLINE_C2_MAX_HALO) {
+        error *= SPLINE_C2_DECAY;
+        ++halo;
+    }
+    return halo;
+}
+
+void splineRegionSource(
+    int imageWidth, int imageHeight, double zoom,
+    int splineType, int c2Halo,
+    int x0, int y0, int regionWidth, int regionHeight,
+    int& srcX0, int& srcY0, int& srcWidth, int& srcHeight
+) {
+    int zoomedWidth, zoomedHeight;
+    splineZoomedSize(
+        imageWidth, imageHeight, zoom, zoomedWidth, zoomedHeight
+    );
+    assert(
+        0 <= x0 && x0 + regionWidth <= zoomedWidth &&
+        0 <= y0 && y0 + regionHeight <= zoomedHeight
+    );
+    splineWindow(
+        *ResamplePlan::get(
+            KERNEL_SPLINE, imageWidth, zoomedWidth,
+            (double) zoomedWidth / (double) imageWidth
+        ),
+        splineType, c2Halo, x0, x0 + regionWidth, srcX0, srcWidth
+    );
+    splineWindow(
+        *ResamplePlan::get(
+            KERNEL_SPLINE, imageHeight, zoomedHeight,
+            (double) zoomedHeight / (double) imageHeight
+        ),
+        splineType, c2Halo, y0, y0 + regionHeight, srcY0, srcHeight
+    );
+}
+
+void splineRegion(
+    const ImageWindow& image,
+    double zoom,
+    int x0, int y0, int regionWidth, int regionHeight,
+    PlanarImage& region,
+    int splineType, /* = 0 */
+    int c2Halo,     /* = 0 */
+    int numThreads, /* = 0 */
+    ResampleControl* control    /* = 0 */
+) {
+    assert(&region != image.part);
+    int imageWidth = image.width;
+    int imageHeight = image.height;
+    int zoomedWidth, zoomedHeight;
+    splineZoomedSize(
+        imageWidth, imageHeight, zoom, zoomedWidth, zoomedHeight
+    );
+    assert(
+        0 <= x0 && x0 + regionWidth <= zoomedWidth &&
+        0 <= y0 && y0 + regionHeight <= zoomedHeight
+    );
+    if (
+        imageWidth <= 0 || imageHeight <= 0 ||
+        regionWidth <= 0 || regionHeight <= 0
+    )
+        return;
+    double realZoomX = (double) zoomedWidth / (double) imageWidth;
+    double realZoomY = (double) zoomedHeight / (double) imageHeight;
+
+    // The source columns and rows the region depends on
+    int firstColumn, numColumns, firstRow, numRows;
+    splineRegionSource(
+        imageWidth, imageHeight, zoom, splineType, c2Halo,
+        x0, y0, regionWidth, regionHeight,
+        firstColumn, firstRow, numColumns, numRows
+    );
+    assert(image.contains(firstColumn, firstRow, numColumns, numRows));
+    addRowsTotal(control, (long long) numRows + regionWidth);
+
+    // 1. Rows of the source image
+    PlanarImage zoomedX(regionWidth, numRows);
+    SplinePass pass;
+    for (int c = 0; c < NUM_PLANES; ++c)
+        pass.src[c] = image.row(c, firstRow) + firstColumn;
+    pass.srcLineStep = image.stride();
+    pass.srcNodeStep = 1;
+    pass.totalNodes = imageWidth;
+    pass.firstNode = firstColumn;
+    pass.numNodes = numColumns;
+    pass.nodeStep = realZoomX;
+    for (int c = 0; c < NUM_PLANES; ++c)
+        pass.dst[c] = zoomedX.planes[c];
+    pass.dstLineStep = zoomedX.stride;
+    pass.dstSampleStep = 1;
+    pass.totalSamples = zoomedWidth;
+    pass.firstSample = x0;
+    pass.numSamples = regionWidth;
+    pass.blockSize = 1;
+    pass.splineType = splineType;
+    pass.restrictValues = false;
+    pass.c2Halo = c2Halo;
+    pass.pieces = 0;
+    pass.numPieces = 0;
+    pass.segments = 0;
+    pass.control = control;
+    runSplinePass(pass, numRows, numThreads);
+    if (isCancelled(control))
+        return;
+
+    // 2. Columns of the intermediate image, by blocks of adjacent columns
+    region.create(regionWidth, regionHeight);
+    for (int c = 0; c < NUM_PLANES; ++c)
+        pass.src[c] = zoomedX.planes[c];
+    pass.srcLineStep = 1;
+    pass.srcNodeStep = zoomedX.stride;
+    pass.totalNodes = imageHeight;
+    pass.firstNode = firstRow;
+    pass.numNodes = numRows;
+    pass.nodeStep = realZoomY;
+    for (int c = 0; c < NUM_PLANES; ++c)
+        pass.dst[c] = region.planes[c];
+    pass.dstLineStep = 1;
+    pass.dstSampleStep = region.stride;
+    pass.totalSamples = zoomedHeight;
+    pass.firstSample = y0;
+    pass.numSamples = regionHeight;
+    pass.blockSize = SPLINE_COLUMN_BLOCK;
+    pass.restrictValues = true;
+    pass.segments = 0;
+    runSplinePass(pass, regionWidth, numThreads);
+}
+
+void bsplineInterpolation(
+    const PlanarImage& image,
+    double zoom,
+    double& realZoomX, double& realZoomY,
+    PlanarImage& zoomed,
+    ResampleControl* control    /* = 0 */
+) {
+    int imageWidth = image.width;
+    int imageHeight = image.height;
+    int zoomedWidth = (int)(imageWidth*zoom + 0.49);
+    int zoomedHeight = (int)(imageHeight*zoom + 0.49);
+    realZoomX = (double) zoomedWidth / (double) imageWidth;
+    realZoomY = (double) zoomedHeight / (double) imageHeight;
+    // The rows of the prefilter, of the horizontal and the vertical
+    // passes of every plane
+    addRowsTotal(
+        control, (long long) NUM_PLANES*(2*imageHeight + zoomedHeight)
+    );
+
+    // The taps and weights of the horizontal pass are the same
+    // for all rows and planes
+    int* tapsX = new int[4*zoomedWidth];
+    double* weightsX = new double[4*zoomedWidth];
     for (int x = 0; x < zoomedWidth; ++x) {
-        int nodeIdx;
-        double nodeY = 0.;
-        for (nodeIdx = 0; nodeIdx < imageHeight; ++nodeIdx) {
-            redSpline.nodes[nodeIdx].x = nodeY;
-            greenSpline.nodes[nodeIdx].x = nodeY;
-            blueSpline.nodes[nodeIdx].x = nodeY;
-
-            RealPixel p = zoomedMatrX[nodeIdx*zoomedWidth + x];
-            redSpline.nodes[nodeIdx].y = p.red();
-            greenSpline.nodes[nodeIdx].y = p.green();
-            blueSpline.nodes[nodeIdx].y = p.blue();
-            nodeY += dy;
-        }
-        if (splineType == 0) {
-            redSpline.interpolateC2();
-            greenSpline.interpolateC2();
-            blueSpline.interpolateC2();
-        } else {
-            redSpline.interpolateC1();
-            greenSpline.interpolateC1();
-            blueSpline.interpolateC1();
+        double t = (double) x / realZoomX;
+        int k = (int) floor(t);
+        bsplineWeights(t - (double) k, weightsX + 4*x);
+        for (int i = 0; i < 4; ++i)
+            tapsX[4*x + i] = bsplineMirror(k - 1 + i, imageWidth);
+    }
+
+    // The planes are processed one by one: the prefilter runs
+    // in doubles on one plane at a time
+    double* coeffs = new double[imageWidth*imageHeight];
+    PlanarImage zoomedX(zoomedWidth, imageHeight);
+    zoomed.create(zoomedWidth, zoomedHeight);
+    for (int c = 0; c < NUM_PLANES && !isCancelled(control); ++c) {
+        // 1. B-spline coefficients: prefilter the rows, then the columns
+        for (int y = 0; y < imageHeight; ++y) {
+            const float* src = image.row(c, y);
+            double* dst = coeffs + y*imageWidth;
+            for (int x = 0; x < imageWidth; ++x)
+                dst[x] = (double) src[x];
+            bsplinePrefilter(dst, imageWidth, 1, 1);
         }
+        bsplinePrefilter(coeffs, imageHeight, imageWidth, imageWidth);
+        addRowsDone(control, imageHeight);
 
-        nodeIdx = 0;
-        for (int y = 0; y < zoomedHeight; ++y) {
-            double yy = (double) y;
-            while (
-                nodeIdx < imageHeight-2 &&
-                yy >= redSpline.nodes[nodeIdx+1].x
-            )
-                ++nodeIdx;
-
-            double v = redSpline.value(
-                yy, nodeIdx
-            );
-            zoomedMatrY[y*zoomedWidth + x].setRed(restrict01(v));
-            v = greenSpline.value(
-                yy, nodeIdx
-            );
-            zoomedMatrY[y*zoomedWidth + x].setGreen(restrict01(v));
-            v = blueSpline.value(
-                yy, nodeIdx
-            );
-            zoomedMatrY[y*zoomedWidth + x].setBlue(restrict01(v));
+        // 2. Horizontal pass: the 4-tap kernel for every output column
+        for (int y = 0; y < imageHeight && !isCancelled(control); ++y) {
+            const double* srcRow = coeffs + y*imageWidth;
+            float* dstRow = zoomedX.row(c, y);
+            for (int x = 0; x < zoomedWidth; ++x) {
+                const int* taps = tapsX + 4*x;
+                const double* w = weightsX + 4*x;
+                dstRow[x] = (float)(
+                    w[0]*srcRow[taps[0]] + w[1]*srcRow[taps[1]] +
+                    w[2]*srcRow[taps[2]] + w[3]*srcRow[taps[3]]
+                );
+            }
+            addRowsDone(control, 1);
         }
-    } // end for (x...
 
-    delete[] zoomedMatrX;
-    *zoomedMatrix = zoomedMatrY;
+        // 3. Vertical pass: a linear combination of 4 rows,
+        // the inner loop goes along the rows
+        for (int y = 0; y < zoomedHeight && !isCancelled(control); ++y) {
+            double t = (double) y / realZoomY;
+            int k = (int) floor(t);
+            double wd[4];
+            bsplineWeights(t - (double) k, wd);
+            float w[4];
+            for (int i = 0; i < 4; ++i)
+                w[i] = (float) wd[i];
+            const float* row0 =
+                zoomedX.row(c, bsplineMirror(k - 1, imageHeight));
+            const float* row1 = zoomedX.row(c, bsplineMirror(k, imageHeight));
+            const float* row2 =
+                zoomedX.row(c, bsplineMirror(k + 1, imageHeight));
+            const float* row3 =
+                zoomedX.row(c, bsplineMirror(k + 2, imageHeight));
+            float* dstRow = zoomed.row(c, y);
+            for (int x = 0; x < zoomedWidth; ++x) {
+                float v = w[0]*row0[x] + w[1]*row1[x] +
+                    w[2]*row2[x] + w[3]*row3[x];
+                dstRow[x] = (v < 0.f)? 0.f : ((v > 1.f)? 1.f : v);
+            }
+            addRowsDone(control, 1);
+        }
+    }
+    delete[] coeffs;
+    delete[] tapsX;
+    delete[] weightsX;
 }
@@ -2,6 +2,9 @@
 #define REAL_PIXEL
 
 #include <cmath>
+#include <functional>
+#include <thread>
+#include <vector>
 
 inline double sigmoid(double x, double coeff = 1.0) {
     return 1./(1. + exp(-(x-0.5)*coeff));
@@ -138,14 +141,130 @@ public:
     }
 };
 
+class PlanarImage;
+struct ImageWindow;
+class ResampleControl;
+
+// Spline interpolation of the image: the rows are interpolated first,
+// then the columns of the result. The size of the zoomed image is
+// the size of the image times zoom (rounded), realZoomX and realZoomY
+// are the exact ratios of the sizes; zoomed is (re)allocated
 void splineInterpolation(
-    int imageWidth, int imageHeight,
-    const RealPixel* imageMatrix,
+    const PlanarImage& image,
+    double zoom,
+    double& realZoomX, double& realZoomY,
+    PlanarImage& zoomed,
+    int splineType = 0, // 0 -- C2-cubic spline, 1 -- C1-spline,
+                        // 2 -- C2-spline through second derivatives
+    int c2Halo = 0,     // C2-splines: 0 -- the splines of the whole lines,
+                        // > 0 -- the windowed solve with this halo
+                        // of nodes (see splineC2Halo)
+    int numThreads = 0, // Rows and columns are interpolated in parallel,
+                        // 0 -- use all processors
+    ResampleControl* control = 0    // Progress and cancellation
+);
+
+// The part x0 <= x < x0 + regionWidth, y0 <= y < y0 + regionHeight
+// of the result of splineInterpolation of the whole image with the same
+// zoom and type, the pixels are the same as in the whole result;
+// region is (re)allocated with the size regionWidth x regionHeight.
+// Only the source pixels given by splineRegionSource are read
+void splineRegion(
+    const ImageWindow& image,
+    double zoom,
+    int x0, int y0, int regionWidth, int regionHeight,
+    PlanarImage& region,
+    int splineType = 0,
+    int c2Halo = 0,
+    int numThreads = 0,
+    ResampleControl* control = 0
+);
+
+// The rectangle of the source image imageWidth x imageHeight that
+// the region of splineRegion depends on. C1-spline is local: the nodes
+// of the region and 1-2 nodes around it. C2-splines are global along
+// the lines, so their regions depend on the whole image, unless
+// they are solved by windows (c2Halo > 0): then the chunks of the region
+// and c2Halo nodes around them are read
+void splineRegionSource(
+    int imageWidth, int imageHeight, double zoom,
+    int splineType, int c2Halo,
+    int x0, int y0, int regionWidth, int regionHeight,
+    int& srcX0, int& srcY0, int& srcWidth, int& srcHeight
+);
+
+// The halo of the windowed C2 solve: the lines are solved by chunks
+// of 64 segments, each on its window with this number of nodes
+// on both sides, so the parts of a line are independent. The values
+// in [0, 1] then differ from the spline of the whole line by at most
+// tolerance (the influence of a node decays geometrically)
+int splineC2Halo(double tolerance);
+
+// Number of threads used by default (the number of processors)
+int defaultNumThreads();
+
+// Run worker(pass, r0, r1) for the contiguous ranges of the lines
+// i0 <= r < i1 in numThreads threads (0 -- defaultNumThreads; in
+// the calling thread if one is enough). The ranges start at multiples of grain from i0, so
+// the blocks of grain lines are not divided. The engines number
+// the rows of all planes together: the row r is the row r % height
+// of the plane r / height
+template <class Pass>
+void runThreadRanges(
+    void (*worker)(const Pass&, int, int), const Pass& pass,
+    int i0, int i1, int numThreads, int grain = 1
+) {
+    if (numThreads <= 0)
+        numThreads = defaultNumThreads();
+    int numBlocks = (i1 - i0 + grain - 1)/grain;
+    if (numThreads > numBlocks)
+        numThreads = numBlocks;
+    if (numThreads <= 1) {
+        worker(pass, i0, i1);
+        return;
+    }
+    std::vector<std::thread> threads;
+    threads.reserve(numThreads);
+    for (int t = 0; t < numThreads; ++t) {
+        int r0 = i0 + (int)((long long) numBlocks*t/numThreads)*grain;
+        int r1 = i0 + (int)((long long) numBlocks*(t + 1)/numThreads)*grain;
+        if (r1 > i1)
+            r1 = i1;
+        threads.push_back(std::thread(worker, std::cref(pass), r0, r1));
+    }
+    for (int t = 0; t < numThreads; ++t)
+        threads[t].join();
+}
+
+// The value clamped to [0, 1]
+inline double restrict01(double v) {
+    if (v < 0.)
+        return 0.;
+    else if (v > 1.)
+        return 1.;
+    else
+        return v;
+}
+
+inline float restrict01(float v) {
+    if (v < 0.f)
+        return 0.f;
+    else if (v > 1.f)
+        return 1.f;
+    else
+        return v;
+}
+
+// Interpolation by the cardinal cubic B-spline on the uniform grid
+// (the same C2-spline with mirror boundary conditions instead of
+// the natural ones). The geometry of the result is the same as
+// in splineInterpolation, that remains the reference implementation
+void bsplineInterpolation(
+    const PlanarImage& image,
     double zoom,
     double& realZoomX, double& realZoomY,
-    int& zoomedWidth, int& zoomedHeight,
-    RealPixel** zoomedMatrix,
-    int splineType = 0  // 0 -- C2-cubic spline, 1 -- C1-spline
+    PlanarImage& zoomed,
+    ResampleControl* control = 0    // Progress and cancellation
 );
 
 #endif
@@ -0,0 +1,75 @@
+#ifndef RESAMPLE_CONTROL_H
+#define RESAMPLE_CONTROL_H
+
+#include <atomic>
+
+// Progress and cancellation of a running engine, shared between
+// the threads of the engine and its client without locks.
+// An engine adds the number of rows of all its passes (the lines
+// of a pass: rows, or columns for the passes along columns) to
+// the total when it starts, and every processed row to the done
+// count; the client reads the counters at any time.
+// cancel() asks the engine to stop: the threads check the flag
+// before every row and return, the result is then incomplete
+class ResampleControl {
+public:
+    ResampleControl():
+        total(0),
+        done(0),
+        cancelFlag(false)
+    {}
+
+    void cancel() { cancelFlag.store(true, std::memory_order_relaxed); }
+    bool isCancelled() const {
+        return cancelFlag.load(std::memory_order_relaxed);
+    }
+
+    void addRowsTotal(long long n) {
+        total.fetch_add(n, std::memory_order_relaxed);
+    }
+    void addRowsDone(long long n) {
+        done.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    long long rowsTotal() const {
+        return total.load(std::memory_order_relaxed);
+    }
+    long long rowsDone() const {
+        return done.load(std::memory_order_relaxed);
+    }
+
+    // Part of the work done, 0..1
+    double progress() const {
+        long long t = rowsTotal();
+        if (t <= 0)
+            return 0.;
+        double p = (double) rowsDone() / (double) t;
+        return (p > 1.)? 1. : p;
+    }
+
+private:
+    std::atomic<long long> total;
+    std::atomic<long long> done;
+    std::atomic<bool> cancelFlag;
+
+    ResampleControl(const ResampleControl&);
+    ResampleControl& operator=(const ResampleControl&);
+};
+
+// The helpers of the engines: control may be 0
+
+inline bool isCancelled(const ResampleControl* control) {
+    return control != 0 && control->isCancelled();
+}
+
+inline void addRowsTotal(ResampleControl* control, long long n) {
+    if (control != 0)
+        control->addRowsTotal(n);
+}
+
+inline void addRowsDone(ResampleControl* control, long long n) {
+    if (control != 0)
+        control->addRowsDone(n);
+}
+
+#endif
@@ -0,0 +1,188 @@
+#include <cassert>
+#include <cmath>
+#include <list>
+#include <mutex>
+#include "ResamplePlan.h"
+
+static std::mutex cacheMutex;
+static std::list< std::shared_ptr<const ResamplePlan> > cachedPlans;
+static int cacheCapacity = 32;
+
+ResamplePlan::ResamplePlan(
+    int k, int srcLength, int dstLength, double s
+):
+    kernel(k),
+    srcSize(srcLength),
+    dstSize(dstLength),
+    step(s),
+    numTaps(0),
+    first(dstLength),
+    frac(),
+    taps(),
+    weights()
+{
+    assert(srcSize > 0 && dstSize >= 0);
+    if (kernel == KERNEL_LINEAR) {
+        numTaps = 2;
+        frac.resize(dstSize);
+        taps.resize(2*dstSize);
+        weights.resize(2*dstSize);
+        for (int j = 0; j < dstSize; ++j) {
+            double pos = step * (double) j;
+            int i0 = (int) pos;
+            double f = pos - (double) i0;
+            first[j] = i0;
+            frac[j] = f;
+
+            int i1 = i0 + 1;
+            double w0 = 1. - f;
+            double w1 = 1. - w0;
+            if (i1 >= srcSize) {
+                i1 = i0;
+                w0 = 1.; w1 = 0.;
+            }
+            if (i0 >= srcSize)
+                i0 = i1 = srcSize - 1;
+            taps[2*j] = i0;
+            taps[2*j + 1] = i1;
+            weights[2*j] = w0;
+            weights[2*j + 1] = w1;
+        }
+    } else if (kernel == KERNEL_AREA) {
+        numTaps = 2;
+        frac.resize(dstSize);
+        taps.resize(2*dstSize);
+        weights.resize(2*dstSize);
+        double size = (double) srcSize;
+        for (int j = 0; j < dstSize; ++j) {
+            double x0 = step * (double) j;
+            double x1 = step * (double) (j + 1);
+            if (x1 > size)
+                x1 = size;
+            int i0, i1;
+            double w0, w1;
+            if (x1 <= x0) {
+                // The box is outside of the axis: the last pixel
+                i0 = i1 = srcSize - 1;
+                w0 = 1.; w1 = 0.;
+                x0 = 0.; x1 = 1.;
+            } else {
+                i0 = (int) x0;
+                i1 = (int) ceil(x1) - 1;
+                if (i1 < i0)
+                    i1 = i0;
+                if (i0 == i1) {
+                    w0 = x1 - x0; w1 = 0.;
+                } else {
+                    w0 = (double)(i0 + 1) - x0;
+                    w1 = x1 - (double) i1;
+                }
+            }
+            first[j] = i0;
+            frac[j] = 1./(x1 - x0);
+            taps[2*j] = i0;
+            taps[2*j + 1] = i1;
+            weights[2*j] = w0;
+            weights[2*j + 1] = w1;
+        }
+    } else if (kernel == KERNEL_CUBIC) {
+        numTaps = 4;
+        frac.resize(dstSize);
+        taps.resize(4*dstSize);
+        weights.resize(4*dstSize);
+        for (int j = 0; j < dstSize; ++j) {
+            double pos = step * (double) j;
+            int i0 = (int) pos;
+            double f = pos - (double) i0;
+            first[j] = i0;
+            frac[j] = f;
+
+            // Catmull-Rom: the same polynomial as
+            //     p1 + 0.5*f*(p2 - p0 + f*(2p0 - 5p1 + 4p2 - p3 +
+            //         f*(3(p1 - p2) + p3 - p0)))
+            double f2 = f*f;
+            double f3 = f2*f;
+            double* w = &(weights[4*j]);
+            w[0] = 0.5*(-f + 2.*f2 - f3);
+            w[1] = 0.5*(2. - 5.*f2 + 3.*f3);
+            w[2] = 0.5*(f + 4.*f2 - 3.*f3);
+            w[3] = 0.5*(f3 - f2);
+            for (int k = 0; k < 4; ++k) {
+                int i = i0 - 1 + k;
+                if (i < 0)
+                    i = 0;
+                else if (i >= srcSize)
+                    i = srcSize - 1;
+                taps[4*j + k] = i;
+            }
+        }
+    } else {
+        assert(kernel == KERNEL_SPLINE);
+
+        // The abscissas of nodes are accumulated in the same way
+        // as in the spline interpolation
+        std::vector<double> nodeX(srcSize);
+        double x = 0.;
+        for (int i = 0; i < srcSize; ++i) {
+            nodeX[i] = x;
+            x += step;
+        }
+        int nodeIdx = 0;
+        for (int j = 0; j < dstSize; ++j) {
+            double xx = (double) j;
+            while (
+                nodeIdx < srcSize-2 &&
+                xx >= nodeX[nodeIdx+1]
+            )
+                ++nodeIdx;
+            first[j] = nodeIdx;
+        }
+    }
+}
+
+std::shared_ptr<const ResamplePlan> ResamplePlan::get(
+    int kernel, int srcSize, int dstSize, double step
+) {
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        std::list< std::shared_ptr<const ResamplePlan> >::iterator i =
+            cachedPlans.begin();
+        for (; i != cachedPlans.end(); ++i) {
+            if ((*i)->matches(kernel, srcSize, dstSize, step)) {
+                // Move to the front: the most recently used
+                cachedPlans.splice(cachedPlans.begin(), cachedPlans, i);
+                return cachedPlans.front();
+            }
+        }
+    }
+
+    // The plan is computed without lock; if another thread
+    // has computed the same plan meanwhile, that one is used
+    std::shared_ptr<const ResamplePlan> plan(
+        new ResamplePlan(kernel, srcSize, dstSize, step)
+    );
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    std::list< std::shared_ptr<const ResamplePlan> >::iterator i =
+        cachedPlans.begin();
+    for (; i != cachedPlans.end(); ++i) {
+        if ((*i)->matches(kernel, srcSize, dstSize, step))
+            return *i;
+    }
+    cachedPlans.push_front(plan);
+    while ((int) cachedPlans.size() > cacheCapacity)
+        cachedPlans.pop_back();
+    return plan;
+}
+
+void ResamplePlan::setCacheCapacity(int capacity) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    cacheCapacity = (capacity > 0)? capacity : 0;
+    while ((int) cachedPlans.size() > cacheCapacity)
+        cachedPlans.pop_back();
+}
+
+void ResamplePlan::clearCache() {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    cachedPlans.clear();
+}
@@ -0,0 +1,72 @@
+#ifndef RESAMPLE_PLAN_H
+#define RESAMPLE_PLAN_H
+
+#include <memory>
+#include <vector>
+
+// Kernels of resampling along one axis
+enum ResampleKernel {
+    KERNEL_LINEAR = 0,  // 2 taps: the source position and the next one
+    KERNEL_SPLINE = 1,  // Segment of spline for every output sample
+    KERNEL_AREA = 2,    // Box of source pixels averaged with coverages
+    KERNEL_CUBIC = 3    // 4 taps of Catmull-Rom (Keys, a = -0.5) cubic
+};
+
+// Resampling plan of one axis: the tables that depend only on the
+// geometry (source size, output size, step) and the kernel, and that
+// are the same for all rows, columns and channels of an image.
+//
+// For the output sample j:
+//     KERNEL_LINEAR: the source position is j*step,
+//         first[j] is its integer part, frac[j] its fractional part,
+//         taps/weights are 2 source indices (clamped at the end of
+//         the axis) and their weights;
+//     KERNEL_SPLINE: the nodes of spline are at i*step (step is
+//         the distance between nodes in output samples), the sample j
+//         is at j; first[j] is the segment of spline that contains j,
+//         frac, taps and weights are not used;
+//     KERNEL_AREA: the output sample j covers the box
+//         [j*step, (j+1)*step) of the source axis (clipped at its end),
+//         taps are the first and the last source pixels of the box,
+//         weights are their coverages (the pixels between them are
+//         covered entirely), frac[j] is the inverse length of the box;
+//         first[j] is the first pixel;
+//     KERNEL_CUBIC: the source position is j*step, first[j] and frac[j]
+//         are as for KERNEL_LINEAR, taps are the 4 source indices
+//         first[j]-1 .. first[j]+2 clamped to the axis, weights are
+//         the Keys cubic weights (their sum is 1).
+class ResamplePlan {
+public:
+    int kernel;
+    int srcSize;
+    int dstSize;
+    double step;
+    int numTaps;
+
+    std::vector<int> first;
+    std::vector<double> frac;
+    std::vector<int> taps;          // numTaps indices per output sample
+    std::vector<double> weights;    // numTaps weights per output sample
+
+    ResamplePlan(int k, int srcLength, int dstLength, double s);
+
+    bool matches(int k, int srcLength, int dstLength, double s) const {
+        return (
+            kernel == k && srcSize == srcLength &&
+            dstSize == dstLength && step == s
+        );
+    }
+
+    // The plan for the geometry from the cache of recently used plans
+    // (LRU, thread-safe). The plans are immutable and can be shared
+    // between threads
+    static std::shared_ptr<const ResamplePlan> get(
+        int kernel, int srcSize, int dstSize, double step
+    );
+
+    // Number of plans kept in the cache
+    static void setCacheCapacity(int capacity);
+    static void clearCache();
+};
+
+#endif
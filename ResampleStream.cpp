@@ -0,0 +1,248 @@
+#include <cassert>
+#include <cctype>
+#include <cstring>
+#include "ResampleStream.h"
+#include "ImageConvert.h"
+
+// Append the source rows y0 <= y < y1 to the band; the rows
+// of the source before y0 the result does not depend on are skipped
+static bool readBand(
+    RowSource& source, int& nextRow, int y0, int y1,
+    PlanarImage& band, int firstRow, PlanarImage& skipped
+) {
+    float* row[NUM_PLANES];
+    for (; nextRow < y0; ++nextRow) {
+        for (int c = 0; c < NUM_PLANES; ++c)
+            row[c] = skipped.row(c, 0);
+        if (!source.readRow(nextRow, row))
+            return false;
+    }
+    for (; nextRow < y1; ++nextRow) {
+        for (int c = 0; c < NUM_PLANES; ++c)
+            row[c] = band.row(c, firstRow + nextRow - y0);
+        if (!source.readRow(nextRow, row))
+            return false;
+    }
+    return true;
+}
+
+bool resampleStream(
+    int width, int height,
+    RowSource& source, RowSink& sink,
+    const ResampleParams& params
+) {
+    if (width <= 0 || height <= 0 || !hasLocalRegions(params))
+        return false;
+    int resultWidth, resultHeight;
+    resampledSize(params, width, height, resultWidth, resultHeight);
+    if (resultWidth <= 0 || resultHeight <= 0)
+        return false;
+    ResampleControl* control = params.control;
+    addRowsTotal(control, resultHeight);
+
+    // The strips report only the rows of the result
+    ResampleParams stripParams = params;
+    stripParams.control = 0;
+
+    // The band holds the source rows bandY0 <= y < bandY1,
+    // the strips need the ranges that only grow
+    PlanarImage band, nextBand, strip;
+    PlanarImage skipped(width, 1);
+    int bandY0 = 0;
+    int bandY1 = 0;
+    const float* row[NUM_PLANES];
+    for (int y0 = 0; y0 < resultHeight; y0 += STREAM_STRIP_ROWS) {
+        if (isCancelled(control))
+            return false;
+        int numRows = resultHeight - y0;
+        if (numRows > STREAM_STRIP_ROWS)
+            numRows = STREAM_STRIP_ROWS;
+        int srcX0, srcY0, srcWidth, srcHeight;
+        if (
+            !resampleRegionSource(
+                params, width, height, 0, y0, resultWidth, numRows,
+                srcX0, srcY0, srcWidth, srcHeight
+            )
+        )
+            return false;
+        int srcY1 = srcY0 + srcHeight;
+        assert(srcY0 >= bandY0 && srcY1 >= bandY1);
+
+        // The rows shared with the previous strip are kept,
+        // the others are read
+        nextBand.create(width, srcHeight);
+        int keep0 = (srcY0 > bandY0)? srcY0 : bandY0;
+        for (int y = keep0; y < bandY1; ++y) {
+            for (int c = 0; c < NUM_PLANES; ++c) {
+                memcpy(
+                    nextBand.row(c, y - srcY0), band.row(c, y - bandY0),
+                    width*sizeof(float)
+                );
+            }
+        }
+        int readY0 = (bandY1 > srcY0)? bandY1 : srcY0;
+        int nextRow = bandY1;
+        if (
+            !readBand(
+                source, nextRow, readY0, srcY1,
+                nextBand, readY0 - srcY0, skipped
+            )
+        )
+            return false;
+        band.swap(nextBand);
+        bandY0 = srcY0;
+        bandY1 = srcY1;
+
+        if (
+            !resampleRegion(
+                band, 0, bandY0, width, height,
+                0, y0, resultWidth, numRows, strip, stripParams
+            )
+        )
+            return false;
+        for (int y = 0; y < numRows; ++y) {
+            for (int c = 0; c < NUM_PLANES; ++c)
+                row[c] = strip.row(c, y);
+            if (!sink.writeRow(y0 + y, row))
+                return false;
+        }
+        addRowsDone(control, numRows);
+    }
+    return true;
+}
+
+// The next number of the PPM header: the whitespace and the comments
+// before it are skipped, one whitespace character after it is read
+static bool readPpmNumber(FILE* file, int& value) {
+    int ch = fgetc(file);
+    while (ch != EOF && (isspace(ch) || ch == '#')) {
+        if (ch == '#') {
+            while (ch != EOF && ch != '\n')
+                ch = fgetc(file);
+        }
+        ch = fgetc(file);
+    }
+    if (ch == EOF || !isdigit(ch))
+        return false;
+    value = 0;
+    while (ch != EOF && isdigit(ch)) {
+        if (value > 100000000)
+            return false;
+        value = value*10 + (ch - '0');
+        ch = fgetc(file);
+    }
+    return ch != EOF && isspace(ch);
+}
+
+PpmRowSource::PpmRowSource():
+    file(0),
+    imageWidth(0),
+    imageHeight(0),
+    nextRow(0),
+    bytes(),
+    line()
+{}
+
+PpmRowSource::~PpmRowSource() {
+    if (file != 0)
+        fclose(file);
+}
+
+bool PpmRowSource::open(const char* path) {
+    if (file != 0)
+        fclose(file);
+    imageWidth = 0;
+    imageHeight = 0;
+    nextRow = 0;
+    file = fopen(path, "rb");
+    if (file == 0)
+        return false;
+    int maxValue;
+    if (
+        fgetc(file) != 'P' || fgetc(file) != '6' ||
+        !readPpmNumber(file, imageWidth) ||
+        !readPpmNumber(file, imageHeight) ||
+        !readPpmNumber(file, maxValue) || maxValue != 255 ||
+        imageWidth <= 0 || imageHeight <= 0
+    ) {
+        fclose(file);
+        file = 0;
+        imageWidth = 0;
+        imageHeight = 0;
+        return false;
+    }
+    bytes.resize((size_t) imageWidth*3);
+    line.create(imageWidth, 1);
+    return true;
+}
+
+bool PpmRowSource::readRow(int y, float* const* row) {
+    assert(y == nextRow);
+    if (file == 0 || y != nextRow || y >= imageHeight)
+        return false;
+    if (fread(bytes.data(), 1, bytes.size(), file) != bytes.size())
+        return false;
+    ++nextRow;
+    importPixels(
+        imageWidth, 1, bytes.data(), (int) bytes.size(), PIXELS_RGB888,
+        line, 1
+    );
+    for (int c = 0; c < NUM_PLANES; ++c)
+        memcpy(row[c], line.row(c, 0), imageWidth*sizeof(float));
+    return true;
+}
+
+PpmRowSink::PpmRowSink():
+    file(0),
+    imageWidth(0),
+    imageHeight(0),
+    nextRow(0),
+    bytes(),
+    line()
+{}
+
+PpmRowSink::~PpmRowSink() {
+    if (file != 0)
+        fclose(file);
+}
+
+bool PpmRowSink::open(const char* path, int width, int height) {
+    if (file != 0)
+        fclose(file);
+    imageWidth = width;
+    imageHeight = height;
+    nextRow = 0;
+    file = fopen(path, "wb");
+    if (file == 0)
+        return false;
+    if (fprintf(file, "P6\n%d %d\n255\n", width, height) < 0)
+        return false;
+    bytes.resize((size_t) width*3);
+    line.create(width, 1);
+    return true;
+}
+
+bool PpmRowSink::close() {
+    if (file == 0)
+        return false;
+    bool ok = (nextRow == imageHeight);
+    if (fclose(file) != 0)
+        ok = false;
+    file = 0;
+    return ok;
+}
+
+bool PpmRowSink::writeRow(int y, const float* const* row) {
+    assert(y == nextRow);
+    if (file == 0 || y != nextRow || y >= imageHeight)
+        return false;
+    for (int c = 0; c < NUM_PLANES; ++c)
+        memcpy(line.row(c, 0), row[c], imageWidth*sizeof(float));
+    exportPixels(
+        line, bytes.data(), (int) bytes.size(), PIXELS_RGB888, 1
+    );
+    if (fwrite(bytes.data(), 1, bytes.size(), file) != bytes.size())
+        return false;
+    ++nextRow;
+    return true;
+}
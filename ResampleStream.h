@@ -0,0 +1,106 @@
+#ifndef RESAMPLE_STREAM_H
+#define RESAMPLE_STREAM_H
+
+#include <cstdio>
+#include <vector>
+#include "PlanarImage.h"
+#include "Resampler.h"
+
+// Streaming resampling of the images that do not fit in memory.
+// The result is computed by strips of STREAM_STRIP_ROWS rows, every
+// strip by resampleRegion from the band of the source rows it depends
+// on (resampleRegionSource). The source rows are pulled from a RowSource
+// when a strip needs them, the band keeps only the rows shared with
+// the next strip, and the rows of a strip are pushed to a RowSink.
+// So the memory depends on the width and the zoom, not on the height,
+// and the rows are the same as those of resampleImage.
+// Only the methods with local regions (hasLocalRegions) are streamed
+
+// Rows of the result computed at once
+const int STREAM_STRIP_ROWS = 64;
+
+// The rows of the source image
+class RowSource {
+public:
+    virtual ~RowSource() {}
+
+    // Fill the source row y: row[c] holds the pixels of the plane c.
+    // The rows are read in increasing order, every row at most once
+    // (the rows after the last one the result depends on are not
+    // read); false stops the processing (a read error)
+    virtual bool readRow(int y, float* const* row) = 0;
+};
+
+// The rows of the result
+class RowSink {
+public:
+    virtual ~RowSink() {}
+
+    // The row y of the result, in increasing order: row[c] holds
+    // the pixels of the plane c; false stops the processing
+    virtual bool writeRow(int y, const float* const* row) = 0;
+};
+
+// The result of resampleImage of the source width x height written
+// to sink; the size of the result is given by resampledSize.
+// The strips are processed in params.numThreads threads; params.control
+// counts the rows of the result and is checked between the strips.
+// Returns false when the method is not local, the parameters are
+// invalid, the source or the sink fails or the call is cancelled
+bool resampleStream(
+    int width, int height,
+    RowSource& source, RowSink& sink,
+    const ResampleParams& params
+);
+
+// Binary PPM file (P6 with the maximal value 255) read by rows
+class PpmRowSource: public RowSource {
+public:
+    PpmRowSource();
+    ~PpmRowSource();
+
+    // Open the file and read its header; false if it is not such a PPM
+    bool open(const char* path);
+    int width() const { return imageWidth; }
+    int height() const { return imageHeight; }
+
+    bool readRow(int y, float* const* row);
+
+private:
+    FILE* file;
+    int imageWidth;
+    int imageHeight;
+    int nextRow;
+    std::vector<unsigned char> bytes;
+    PlanarImage line;
+
+    PpmRowSource(const PpmRowSource&);
+    PpmRowSource& operator=(const PpmRowSource&);
+};
+
+// Binary PPM file written by rows
+class PpmRowSink: public RowSink {
+public:
+    PpmRowSink();
+    ~PpmRowSink();
+
+    // Create the file of width x height pixels and write its header
+    bool open(const char* path, int width, int height);
+    // False if a row was not written or the file is not complete
+    bool close();
+
+    bool writeRow(int y, const float* const* row);
+
+private:
+    FILE* file;
+    int imageWidth;
+    int imageHeight;
+    int nextRow;
+    std::vector<unsigned char> bytes;
+    PlanarImage line;
+
+    PpmRowSink(const PpmRowSink&);
+    PpmRowSink& operator=(const PpmRowSink&);
+};
+
+#endif
@@ -0,0 +1,123 @@
+#include <QElapsedTimer>
+#include "ResampleTask.h"
+#include "Bilinear.h"
+#include "ImageConvert.h"
+#include "QImagePlanes.h"
+
+ResampleTask::ResampleTask(
+    std::shared_ptr<const PlanarImage> source,
+    const ResampleParams& params,
+    int target,
+    QObject* parent /* = 0 */
+):
+    QObject(parent),
+    params(params),
+    target(target),
+    withPreview(false),
+    region(),
+    control(),
+    previewControl(),
+    previewImage(),
+    ok(false),
+    result(new PlanarImage()),
+    resultImage(),
+    seconds(0.),
+    source(source),
+    sourceImage()
+{
+    setAutoDelete(false);
+    this->params.control = &control;
+}
+
+ResampleTask::ResampleTask(
+    const QImage& sourceImage,
+    const ResampleParams& params,
+    int target,
+    QObject* parent /* = 0 */
+):
+    QObject(parent),
+    params(params),
+    target(target),
+    withPreview(false),
+    region(),
+    control(),
+    previewControl(),
+    previewImage(),
+    ok(false),
+    result(new PlanarImage()),
+    resultImage(),
+    seconds(0.),
+    source(),
+    sourceImage(sourceImage.convertToFormat(QImage::Format_RGB32))
+{
+    setAutoDelete(false);
+    this->params.control = &control;
+}
+
+void ResampleTask::run() {
+    QElapsedTimer timer;
+    timer.start();
+    if (source && withPreview)
+        makePreview();
+    if (source && !region.isEmpty()) {
+        ok = resampleRegion(
+            *source, region.x(), region.y(),
+            region.width(), region.height(), *result, params
+        );
+        if (ok)
+            resultImage = planesToImage(*result, params.numThreads);
+    } else if (source) {
+        ok = resampleImage(*source, *result, params);
+        if (ok)
+            resultImage = planesToImage(*result, params.numThreads);
+    } else {
+        // The scanlines are interpolated directly, then the planes
+        // are defined by the result
+        int w = sourceImage.width();
+        int h = sourceImage.height();
+        int resultWidth, resultHeight;
+        resampledSize(params, w, h, resultWidth, resultHeight);
+        ok = (w > 0 && h > 0 && resultWidth > 0 && resultHeight > 0);
+        if (ok) {
+            resultImage = QImage(
+                resultWidth, resultHeight, QImage::Format_RGB32
+            );
+            ok = resamplePixels(
+                w, h,
+                sourceImage.constBits(), sourceImage.bytesPerLine(),
+                PIXELS_XRGB32,
+                resultImage.bits(), resultImage.bytesPerLine(),
+                PIXELS_XRGB32,
+                params
+            );
+        }
+        if (ok)
+            imageToPlanes(resultImage, *result, params.numThreads);
+    }
+    if (!ok) {
+        result.reset();
+        resultImage = QImage();
+    }
+    seconds = (double) timer.elapsed() / 1000.;
+    emit finished();
+}
+
+void ResampleTask::makePreview() {
+    int w = source->width;
+    int h = source->height;
+    int resultWidth, resultHeight;
+    resampledSize(params, w, h, resultWidth, resultHeight);
+    if (w <= 0 || h <= 0 || resultWidth <= 0 || resultHeight <= 0)
+        return;
+    PlanarImage preview;
+    bilinearInterpolation(
+        *source, resultWidth, resultHeight, preview,
+        (double) w / (double) resultWidth,
+        (double) h / (double) resultHeight,
+        params.numThreads, &previewControl
+    );
+    if (previewControl.isCancelled())
+        return;
+    previewImage = planesToImage(preview, params.numThreads);
+    emit previewReady();
+}
@@ -0,0 +1,78 @@
+#ifndef RESAMPLE_TASK_H
+#define RESAMPLE_TASK_H
+
+#include <memory>
+#include <QObject>
+#include <QRunnable>
+#include <QImage>
+#include <QRect>
+#include "PlanarImage.h"
+#include "Resampler.h"
+
+// One call of the engines library run by QThreadPool, so the window
+// keeps repainting while the image is processed. The source is shared
+// (it is not copied and must not be changed while the task runs);
+// the result and its QImage are made in the worker thread, then
+// finished() is emitted and received in the thread of the window.
+// The progress and the cancellation go through control; a cancelled
+// task still emits finished() with ok == false.
+// With withPreview the bilinear result of the same size is made first
+// and previewReady() is emitted, so the window shows it while
+// the method itself runs.
+// The task is not deleted by the pool: the receiver of finished()
+// deletes it (deleteLater)
+class ResampleTask: public QObject, public QRunnable
+{
+    Q_OBJECT
+public:
+    // Planar source, resampleImage
+    ResampleTask(
+        std::shared_ptr<const PlanarImage> source,
+        const ResampleParams& params,
+        int target,
+        QObject* parent = 0
+    );
+    // 8-bit source read by resamplePixels (METHOD_BILINEAR8)
+    ResampleTask(
+        const QImage& sourceImage,
+        const ResampleParams& params,
+        int target,
+        QObject* parent = 0
+    );
+
+    ResampleParams params;
+    int target;             // What the receiver does with the result
+    bool withPreview;       // Planar source only
+    QRect region;           // Part of the result (resampleRegion),
+                            // empty -- the whole result
+    ResampleControl control;
+    ResampleControl previewControl;
+
+    // Valid after previewReady()
+    QImage previewImage;
+
+    // Valid after finished()
+    bool ok;
+    std::shared_ptr<PlanarImage> result;
+    QImage resultImage;
+    double seconds;         // Time of run()
+
+    void cancel() {
+        previewControl.cancel();
+        control.cancel();
+    }
+
+    void run();
+
+signals:
+    void previewReady();
+    void finished();
+
+private:
+    std::shared_ptr<const PlanarImage> source;
+    QImage sourceImage;
+
+    void makePreview();
+};
+
+#endif
@@ -0,0 +1,623 @@
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include "Resampler.h"
+#include "GaussFilter.h"
+#include "PixelMixing.h"
+#include "PixelFilters.h"
+#include "Bicubic.h"
+#include "Bilinear.h"
+#include "Bilinear8.h"
+#include "ImageConvert.h"
+#include "ResamplePlan.h"
+
+struct MethodName {
+    const char* name;
+    const char* description;
+};
+
+// In the order of ResampleMethod
+static const MethodName METHOD_NAMES[NUM_RESAMPLE_METHODS] = {
+    {"bilinear", "bilinear interpolation"},
+    {"bilinear8", "bilinear interpolation of 8-bit pixels"},
+    {"bicubic", "bicubic (Catmull-Rom) interpolation"},
+    {"spline-c1", "C1 cubic spline"},
+    {"spline-c2", "C2 cubic spline"},
+    {"spline-c2d", "C2 cubic spline through second derivatives"},
+    {"bspline", "cubic B-spline on the uniform grid"},
+    {"mixing", "area averaging (downscale)"},
+    {"gauss", "Gaussian filter, the size is kept"},
+    {"gauss-resize", "Gaussian filter, then bilinear"},
+    {"grayscale", "luminance, the size is kept"},
+    {"high-pass", "high-pass filter, the size is kept"}
+};
+
+ResampleParams::ResampleParams():
+    method(METHOD_SPLINE_C1),
+    zoom(4.),
+    sigma(1.),
+    radius(5),
+    contrast(1.),
+    splineTolerance(0.),
+    numThreads(0),
+    control(0)
+{}
+
+const char* resampleMethodName(int method) {
+    if (method < 0 || method >= NUM_RESAMPLE_METHODS)
+        return "";
+    return METHOD_NAMES[method].name;
+}
+
+const char* resampleMethodDescription(int method) {
+    if (method < 0 || method >= NUM_RESAMPLE_METHODS)
+        return "";
+    return METHOD_NAMES[method].description;
+}
+
+int findResampleMethod(const char* name) {
+    for (int m = 0; m < NUM_RESAMPLE_METHODS; ++m) {
+        if (strcmp(name, METHOD_NAMES[m].name) == 0)
+            return m;
+    }
+    return (-1);
+}
+
+void resampledSize(
+    const ResampleParams& params,
+    int width, int height,
+    int& resultWidth, int& resultHeight
+) {
+    double zoom = params.zoom;
+    switch (params.method) {
+    case METHOD_GAUSS:
+    case METHOD_GRAYSCALE:
+    case METHOD_HIGH_PASS:
+        resultWidth = width;
+        resultHeight = height;
+        break;
+    case METHOD_SPLINE_C1:
+    case METHOD_SPLINE_C2:
+    case METHOD_SPLINE_C2D:
+    case METHOD_BSPLINE:
+        // As in splineInterpolation
+        resultWidth = (int)(width*zoom + 0.49);
+        resultHeight = (int)(height*zoom + 0.49);
+        break;
+    default:
+        resultWidth = (int)((double) width * zoom);
+        resultHeight = (int)((double) height * zoom);
+    }
+}
+
+static bool validParams(const ResampleParams& params) {
+    if (params.method < 0 || params.method >= NUM_RESAMPLE_METHODS)
+        return false;
+    if (!(params.zoom > 0.) || !std::isfinite(params.zoom))
+        return false;
+    if (
+        (params.method == METHOD_GAUSS ||
+        params.method == METHOD_GAUSS_RESIZE) &&
+        !(params.sigma > 0.)
+    )
+        return false;
+    if (!(params.splineTolerance >= 0.))
+        return false;
+    return true;
+}
+
+// splineType of splineInterpolation for the spline methods
+static int splineTypeOf(int method) {
+    if (method == METHOD_SPLINE_C1)
+        return 1;
+    return (method == METHOD_SPLINE_C2)? 0 : 2;
+}
+
+// c2Halo of splineInterpolation
+static int splineHaloOf(const ResampleParams& params) {
+    if (params.splineTolerance > 0.)
+        return splineC2Halo(params.splineTolerance);
+    return 0;
+}
+
+bool resampleImage(
+    const PlanarImage& image,
+    PlanarImage& result,
+    const ResampleParams& params
+) {
+    if (!validParams(params) || &result == &image)
+        return false;
+    int imageWidth = image.width;
+    int imageHeight = image.height;
+    int resultWidth, resultHeight;
+    resampledSize(params, imageWidth, imageHeight, resultWidth, resultHeight);
+    if (
+        imageWidth <= 0 || imageHeight <= 0 ||
+        resultWidth <= 0 || resultHeight <= 0
+    )
+        return false;
+
+    int numThreads = params.numThreads;
+    ResampleControl* control = params.control;
+    double zoom = params.zoom;
+    double invZoom = 1./zoom;
+    double realZoomX, realZoomY;
+    switch (params.method) {
+    case METHOD_BILINEAR:
+        bilinearInterpolation(
+            image, resultWidth, resultHeight, result,
+            (double) imageWidth / (double) resultWidth,
+            (double) imageHeight / (double) resultHeight,
+            numThreads, control
+        );
+        break;
+    case METHOD_BILINEAR8: {
+            // The planes are quantized to 8 bits, interpolated
+            // and converted back
+            int bytesPerLine = 4*imageWidth;
+            int resultBytesPerLine = 4*resultWidth;
+            std::vector<unsigned char> bits(
+                (size_t) bytesPerLine*(size_t) imageHeight
+            );
+            std::vector<unsigned char> resultBits(
+                (size_t) resultBytesPerLine*(size_t) resultHeight
+            );
+            exportPixels(
+                image, bits.data(), bytesPerLine, PIXELS_XRGB32, numThreads
+            );
+            bilinearInterpolation8(
+                imageWidth, imageHeight, bits.data(), bytesPerLine,
+                resultWidth, resultHeight,
+                resultBits.data(), resultBytesPerLine,
+                (double) imageWidth / (double) resultWidth,
+                (double) imageHeight / (double) resultHeight,
+                numThreads, control
+            );
+            if (isCancelled(control))
+                return false;
+            importPixels(
+                resultWidth, resultHeight,
+                resultBits.data(), resultBytesPerLine, PIXELS_XRGB32,
+                result, numThreads
+            );
+        }
+        break;
+    case METHOD_BICUBIC:
+        bicubicInterpolation(
+            image, resultWidth, resultHeight, result,
+            invZoom, invZoom, numThreads, control
+        );
+        break;
+    case METHOD_SPLINE_C1:
+        splineInterpolation(
+            image, zoom, realZoomX, realZoomY, result, 1, 0,
+            numThreads, control
+        );
+        break;
+    case METHOD_SPLINE_C2:
+        splineInterpolation(
+            image, zoom, realZoomX, realZoomY, result, 0,
+            splineHaloOf(params), numThreads, control
+        );
+        break;
+    case METHOD_SPLINE_C2D:
+        splineInterpolation(
+            image, zoom, realZoomX, realZoomY, result, 2,
+            splineHaloOf(params), numThreads, control
+        );
+        break;
+    case METHOD_BSPLINE:
+        bsplineInterpolation(
+            image, zoom, realZoomX, realZoomY, result, control
+        );
+        break;
+    case METHOD_PIXEL_MIXING:
+        pixelMixing(
+            image, resultWidth, resultHeight, result,
+            invZoom, invZoom, numThreads, control
+        );
+        break;
+    case METHOD_GAUSS:
+        gaussFilter(
+            image, result, params.sigma, params.radius,
+            GAUSS_AUTO, numThreads, control
+        );
+        break;
+    case METHOD_GAUSS_RESIZE: {
+            PlanarImage filtered;
+            gaussFilter(
+                image, filtered, params.sigma, params.radius,
+                GAUSS_AUTO, numThreads, control
+            );
+            if (isCancelled(control))
+                return false;
+            bilinearInterpolation(
+                filtered, resultWidth, resultHeight, result,
+                invZoom, invZoom, numThreads, control
+            );
+        }
+        break;
+    case METHOD_GRAYSCALE:
+        grayscaleFilter(image, result, numThreads, control);
+        break;
+    case METHOD_HIGH_PASS:
+        highPassFilter(
+            image, result, params.contrast, numThreads, control
+        );
+        break;
+    }
+    if (isCancelled(control))
+        return false;
+    return !result.isNull();
+}
+
+// The source rows (or columns) s0 <= i < s0 + n of the taps
+// of the output samples j0 <= j < j1 (the taps grow with j)
+static void planSource(
+    const ResamplePlan& plan, int j0, int j1, int& s0, int& n
+) {
+    int numTaps = plan.numTaps;
+    s0 = plan.taps[numTaps*j0];
+    n = plan.taps[numTaps*(j1 - 1) + numTaps - 1] + 1 - s0;
+}
+
+// The source of the part of the result of a resampler with the kernel
+static void kernelSource(
+    int kernel, int imageWidth, int imageHeight,
+    int resultWidth, int resultHeight, double stepX, double stepY,
+    int x0, int y0, int regionWidth, int regionHeight,
+    int& srcX0, int& srcY0, int& srcWidth, int& srcHeight
+) {
+    planSource(
+        *ResamplePlan::get(kernel, imageWidth, resultWidth, stepX),
+        x0, x0 + regionWidth, srcX0, srcWidth
+    );
+    planSource(
+        *ResamplePlan::get(kernel, imageHeight, resultHeight, stepY),
+        y0, y0 + regionHeight, srcY0, srcHeight
+    );
+}
+
+// The rectangle extended by halo pixels and clipped by the image,
+// halo < 0 -- the whole image
+static void extendSource(
+    int halo, int imageWidth, int imageHeight,
+    int& srcX0, int& srcY0, int& srcWidth, int& srcHeight
+) {
+    if (halo < 0) {
+        srcX0 = 0;
+        srcY0 = 0;
+        srcWidth = imageWidth;
+        srcHeight = imageHeight;
+        return;
+    }
+    int x1 = srcX0 + srcWidth + halo;
+    int y1 = srcY0 + srcHeight + halo;
+    srcX0 = (srcX0 > halo)? srcX0 - halo : 0;
+    srcY0 = (srcY0 > halo)? srcY0 - halo : 0;
+    srcWidth = ((x1 < imageWidth)? x1 : imageWidth) - srcX0;
+    srcHeight = ((y1 < imageHeight)? y1 : imageHeight) - srcY0;
+}
+
+// The copy of the rectangle of the image
+static void cropImage(
+    const ImageWindow& image, int x0, int y0, int width, int height,
+    PlanarImage& crop
+) {
+    crop.create(width, height);
+    for (int c = 0; c < NUM_PLANES; ++c) {
+        for (int y = 0; y < height; ++y) {
+            memcpy(
+                crop.row(c, y), image.row(c, y0 + y) + x0,
+                width*sizeof(float)
+            );
+        }
+    }
+}
+
+bool resampleRegionSource(
+    const ResampleParams& params,
+    int imageWidth, int imageHeight,
+    int x0, int y0, int regionWidth, int regionHeight,
+    int& srcX0, int& srcY0, int& srcWidth, int& srcHeight
+) {
+    if (!validParams(params))
+        return false;
+    int resultWidth, resultHeight;
+    resampledSize(params, imageWidth, imageHeight, resultWidth, resultHeight);
+    if (
+        imageWidth <= 0 || imageHeight <= 0 ||
+        regionWidth <= 0 || regionHeight <= 0 ||
+        x0 < 0 || x0 > resultWidth - regionWidth ||
+        y0 < 0 || y0 > resultHeight - regionHeight
+    )
+        return false;
+
+    double invZoom = 1./params.zoom;
+    srcX0 = x0;
+    srcY0 = y0;
+    srcWidth = regionWidth;
+    srcHeight = regionHeight;
+    switch (params.method) {
+    case METHOD_BILINEAR:
+    case METHOD_BILINEAR8:
+        kernelSource(
+            KERNEL_LINEAR, imageWidth, imageHeight,
+            resultWidth, resultHeight,
+            (double) imageWidth / (double) resultWidth,
+            (double) imageHeight / (double) resultHeight,
+            x0, y0, regionWidth, regionHeight,
+            srcX0, srcY0, srcWidth, srcHeight
+        );
+        break;
+    case METHOD_BICUBIC:
+        kernelSource(
+            KERNEL_CUBIC, imageWidth, imageHeight,
+            resultWidth, resultHeight, invZoom, invZoom,
+            x0, y0, regionWidth, regionHeight,
+            srcX0, srcY0, srcWidth, srcHeight
+        );
+        break;
+    case METHOD_SPLINE_C1:
+    case METHOD_SPLINE_C2:
+    case METHOD_SPLINE_C2D:
+        splineRegionSource(
+            imageWidth, imageHeight, params.zoom,
+            splineTypeOf(params.method), splineHaloOf(params),
+            x0, y0, regionWidth, regionHeight,
+            srcX0, srcY0, srcWidth, srcHeight
+        );
+        break;
+    case METHOD_BSPLINE:
+        // The prefilter is recursive along the whole lines
+        extendSource(
+            -1, imageWidth, imageHeight, srcX0, srcY0, srcWidth, srcHeight
+        );
+        break;
+    case METHOD_PIXEL_MIXING:
+        kernelSource(
+            KERNEL_AREA, imageWidth, imageHeight,
+            resultWidth, resultHeight, invZoom, invZoom,
+            x0, y0, regionWidth, regionHeight,
+            srcX0, srcY0, srcWidth, srcHeight
+        );
+        // The prefix sums of the rows start at the blocks
+        srcWidth += srcX0%MIXING_BLOCK;
+        srcX0 -= srcX0%MIXING_BLOCK;
+        break;
+    case METHOD_GAUSS:
+        extendSource(
+            gaussHalo(params.sigma, params.radius),
+            imageWidth, imageHeight, srcX0, srcY0, srcWidth, srcHeight
+        );
+        break;
+    case METHOD_GAUSS_RESIZE:
+        // The filtered pixels of the bilinear taps
+        kernelSource(
+            KERNEL_LINEAR, imageWidth, imageHeight,
+            resultWidth, resultHeight, invZoom, invZoom,
+            x0, y0, regionWidth, regionHeight,
+            srcX0, srcY0, srcWidth, srcHeight
+        );
+        extendSource(
+            gaussHalo(params.sigma, params.radius),
+            imageWidth, imageHeight, srcX0, srcY0, srcWidth, srcHeight
+        );
+        break;
+    case METHOD_GRAYSCALE:
+        break;
+    case METHOD_HIGH_PASS:
+        extendSource(
+            1, imageWidth, imageHeight, srcX0, srcY0, srcWidth, srcHeight
+        );
+        break;
+    }
+    return true;
+}
+
+bool hasLocalRegions(const ResampleParams& params) {
+    switch (params.method) {
+    case METHOD_SPLINE_C2:
+    case METHOD_SPLINE_C2D:
+        return params.splineTolerance > 0.;
+    case METHOD_BSPLINE:
+        return false;
+    case METHOD_GAUSS:
+    case METHOD_GAUSS_RESIZE:
+        return (
+            params.sigma > 0. && gaussHalo(params.sigma, params.radius) >= 0
+        );
+    default:
+        return true;
+    }
+}
+
+bool resampleRegion(
+    const PlanarImage& image,
+    int x0, int y0, int regionWidth, int regionHeight,
+    PlanarImage& region,
+    const ResampleParams& params
+) {
+    return resampleRegion(
+        image, 0, 0, image.width, image.height,
+        x0, y0, regionWidth, regionHeight, region, params
+    );
+}
+
+bool resampleRegion(
+    const PlanarImage& part, int partX0, int partY0,
+    int imageWidth, int imageHeight,
+    int x0, int y0, int regionWidth, int regionHeight,
+    PlanarImage& region,
+    const ResampleParams& params
+) {
+    int srcX0, srcY0, srcWidth, srcHeight;
+    if (
+        &region == &part ||
+        !resampleRegionSource(
+            params, imageWidth, imageHeight,
+            x0, y0, regionWidth, regionHeight,
+            srcX0, srcY0, srcWidth, srcHeight
+        )
+    )
+        return false;
+    ImageWindow image(part, partX0, partY0, imageWidth, imageHeight);
+    if (!image.contains(srcX0, srcY0, srcWidth, srcHeight))
+        return false;
+
+    int resultWidth, resultHeight;
+    resampledSize(params, imageWidth, imageHeight, resultWidth, resultHeight);
+    int numThreads = params.numThreads;
+    ResampleControl* control = params.control;
+    double zoom = params.zoom;
+    double invZoom = 1./zoom;
+    switch (params.method) {
+    case METHOD_BILINEAR:
+        bilinearRegion(
+            image, resultWidth, resultHeight,
+            x0, y0, regionWidth, regionHeight, region,
+            (double) imageWidth / (double) resultWidth,
+            (double) imageHeight / (double) resultHeight,
+            numThreads, control
+        );
+        break;
+    case METHOD_BILINEAR8: {
+            // The source pixels of the part are quantized to 8 bits
+            // as in resampleImage
+            PlanarImage crop;
+            cropImage(image, srcX0, srcY0, srcWidth, srcHeight, crop);
+            int bytesPerLine = 4*srcWidth;
+            int regionBytesPerLine = 4*regionWidth;
+            std::vector<unsigned char> bits(
+                (size_t) bytesPerLine*(size_t) srcHeight
+            );
+            std::vector<unsigned char> regionBits(
+                (size_t) regionBytesPerLine*(size_t) regionHeight
+            );
+            exportPixels(
+                crop, bits.data(), bytesPerLine, PIXELS_XRGB32, numThreads
+            );
+            bilinearRegion8(
+                imageWidth, imageHeight,
+                bits.data(), bytesPerLine, srcX0, srcY0,
+                resultWidth, resultHeight,
+                x0, y0, regionWidth, regionHeight,
+                regionBits.data(), regionBytesPerLine,
+                (double) imageWidth / (double) resultWidth,
+                (double) imageHeight / (double) resultHeight,
+                numThreads, control
+            );
+            if (isCancelled(control))
+                return false;
+            importPixels(
+                regionWidth, regionHeight,
+                regionBits.data(), regionBytesPerLine, PIXELS_XRGB32,
+                region, numThreads
+            );
+        }
+        break;
+    case METHOD_BICUBIC:
+        bicubicRegion(
+            image, resultWidth, resultHeight,
+            x0, y0, regionWidth, regionHeight, region,
+            invZoom, invZoom, numThreads, control
+        );
+        break;
+    case METHOD_SPLINE_C1:
+    case METHOD_SPLINE_C2:
+    case METHOD_SPLINE_C2D:
+        splineRegion(
+            image, zoom, x0, y0, regionWidth, regionHeight, region,
+            splineTypeOf(params.method), splineHaloOf(params),
+            numThreads, control
+        );
+        break;
+    case METHOD_PIXEL_MIXING:
+        pixelMixingRegion(
+            image, resultWidth, resultHeight,
+            x0, y0, regionWidth, regionHeight, region,
+            invZoom, invZoom, numThreads, control
+        );
+        break;
+    case METHOD_GAUSS_RESIZE: {
+            // The filtered source of the bilinear taps: the filter
+            // is exact inside its halo
+            PlanarImage crop, filtered;
+            cropImage(image, srcX0, srcY0, srcWidth, srcHeight, crop);
+            gaussFilter(
+                crop, filtered, params.sigma, params.radius,
+                GAUSS_AUTO, numThreads, control
+            );
+            if (isCancelled(control))
+                return false;
+            bilinearRegion(
+                ImageWindow(filtered, srcX0, srcY0, imageWidth, imageHeight),
+                resultWidth, resultHeight,
+                x0, y0, regionWidth, regionHeight, region,
+                invZoom, invZoom, numThreads, control
+            );
+        }
+        break;
+    default: {
+            // The filters that keep the size and the B-spline:
+            // the method processes the source of the part (with its
+            // halo, or the whole image), then the part is cut out
+            PlanarImage crop, processed;
+            cropImage(image, srcX0, srcY0, srcWidth, srcHeight, crop);
+            if (!resampleImage(crop, processed, params))
+                return false;
+            cropImage(
+                ImageWindow(
+                    processed, srcX0, srcY0, resultWidth, resultHeight
+                ),
+                x0, y0, regionWidth, regionHeight, region
+            );
+        }
+        break;
+    }
+    if (isCancelled(control))
+        return false;
+    return !region.isNull();
+}
+
+bool resamplePixels(
+    int width, int height,
+    const unsigned char* bits, int bytesPerLine, int layout,
+    unsigned char* resultBits, int resultBytesPerLine, int resultLayout,
+    const ResampleParams& params
+) {
+    if (!validParams(params) || width <= 0 || height <= 0)
+        return false;
+    int resultWidth, resultHeight;
+    resampledSize(params, width, height, resultWidth, resultHeight);
+    if (resultWidth <= 0 || resultHeight <= 0)
+        return false;
+
+    // The 8-bit bilinear interpolation reads the pixels directly
+    if (
+        params.method == METHOD_BILINEAR8 &&
+        layout == PIXELS_XRGB32 && resultLayout == PIXELS_XRGB32
+    ) {
+        bilinearInterpolation8(
+            width, height, bits, bytesPerLine,
+            resultWidth, resultHeight, resultBits, resultBytesPerLine,
+            (double) width / (double) resultWidth,
+            (double) height / (double) resultHeight,
+            params.numThreads, params.control
+        );
+        return !isCancelled(params.control);
+    }
+
+    PlanarImage image;
+    importPixels(
+        width, height, bits, bytesPerLine, layout, image, params.numThreads
+    );
+    PlanarImage result;
+    if (!resampleImage(image, result, params))
+        return false;
+    exportPixels(
+        result, resultBits, resultBytesPerLine, resultLayout,
+        params.numThreads
+    );
+    return true;
+}
@@ -0,0 +1,127 @@
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include "PlanarImage.h"
+#include "ResampleControl.h"
+
+// The entry of the engines library: all resamplers and filters behind
+// one call with the parameters in a structure. The functions have no
+// state of their own (the only shared data is the thread-safe cache
+// of ResamplePlan), so any number of calls may run at once in
+// different threads, each with its own input and output.
+
+// Methods of resampleImage
+enum ResampleMethod {
+    METHOD_BILINEAR = 0,
+    METHOD_BILINEAR8 = 1,       // Bilinear8.h on 8-bit pixels
+    METHOD_BICUBIC = 2,
+    METHOD_SPLINE_C1 = 3,
+    METHOD_SPLINE_C2 = 4,
+    METHOD_SPLINE_C2D = 5,      // C2-spline through second derivatives
+    METHOD_BSPLINE = 6,
+    METHOD_PIXEL_MIXING = 7,
+    METHOD_GAUSS = 8,           // Gaussian filter, the size is kept
+    METHOD_GAUSS_RESIZE = 9,    // Gaussian filter, then bilinear
+    METHOD_GRAYSCALE = 10,      // The size is kept
+    METHOD_HIGH_PASS = 11,      // The size is kept
+    NUM_RESAMPLE_METHODS = 12
+};
+
+struct ResampleParams {
+    int method;
+    double zoom;            // Output pixels per source pixel
+    double sigma;           // Gaussian filter
+    int radius;             // Maximal size of the truncated Gauss kernel
+    double contrast;        // Sigmoid coefficient of the high-pass filter
+    double splineTolerance; // C2 splines: 0 -- the exact splines of
+                            // the whole lines, > 0 -- solved by windows
+                            // with this error (the parts are then local)
+    int numThreads;         // 0 -- use all processors
+    ResampleControl* control;   // Progress and cancellation, 0 -- none;
+                                // the methods of several engines add
+                                // the totals of the engines one by one
+
+    ResampleParams();
+};
+
+// Short name of the method ("spline-c1", ...) and its description
+const char* resampleMethodName(int method);
+const char* resampleMethodDescription(int method);
+
+// The method of the name; -1 if there is no such method
+int findResampleMethod(const char* name);
+
+// Size of the result of resampleImage for the source width x height
+void resampledSize(
+    const ResampleParams& params,
+    int width, int height,
+    int& resultWidth, int& resultHeight
+);
+
+// The result of the method; result is (re)allocated with
+// the size given by resampledSize. Returns false when the parameters
+// are invalid, the result is empty or the call was cancelled through
+// params.control (the result is then incomplete)
+bool resampleImage(
+    const PlanarImage& image,
+    PlanarImage& result,
+    const ResampleParams& params
+);
+
+// The part x0 <= x < x0 + regionWidth, y0 <= y < y0 + regionHeight
+// of the result of resampleImage (of the size given by resampledSize),
+// the pixels are the same as in the whole result; region is
+// (re)allocated with the size of the part. Every method has regions;
+// only the source pixels the part depends on are read and processed
+// (see resampleRegionSource). Returns false when the parameters are
+// invalid, the part is not inside the result or the call was cancelled
+bool resampleRegion(
+    const PlanarImage& image,
+    int x0, int y0, int regionWidth, int regionHeight,
+    PlanarImage& region,
+    const ResampleParams& params
+);
+
+// The same from a part of the source only: part holds the pixels
+// partX0 <= x < partX0 + part.width, partY0 <= y < partY0 + part.height
+// of the source image of imageWidth x imageHeight pixels, and it has to
+// contain the rectangle given by resampleRegionSource (false otherwise).
+// So a crop of a large image is computed without loading all of it
+bool resampleRegion(
+    const PlanarImage& part, int partX0, int partY0,
+    int imageWidth, int imageHeight,
+    int x0, int y0, int regionWidth, int regionHeight,
+    PlanarImage& region,
+    const ResampleParams& params
+);
+
+// The rectangle of the source image imageWidth x imageHeight
+// that the part of the result of resampleRegion depends on.
+// Returns false when the parameters are invalid or the part
+// is not inside the result
+bool resampleRegionSource(
+    const ResampleParams& params,
+    int imageWidth, int imageHeight,
+    int x0, int y0, int regionWidth, int regionHeight,
+    int& srcX0, int& srcY0, int& srcWidth, int& srcHeight
+);
+
+// True if the parts of the result depend only on the source near them.
+// The exact C2 splines (splineTolerance == 0), the B-spline and
+// the recursive Gaussian filter (large sigma) are global along
+// the lines: their parts depend on the whole image and cost as much
+// as the whole result
+bool hasLocalRegions(const ResampleParams& params);
+
+// The same for 8-bit images given by the pointers to the first rows
+// and the distances between rows in bytes (layouts of ImageConvert.h).
+// The memory of the result is owned by the caller, its size must be
+// given by resampledSize
+bool resamplePixels(
+    int width, int height,
+    const unsigned char* bits, int bytesPerLine, int layout,
+    unsigned char* resultBits, int resultBytesPerLine, int resultLayout,
+    const ResampleParams& params
+);
+
+#endif
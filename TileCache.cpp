@@ -0,0 +1,114 @@
+#include <QThreadPool>
+#include "TileCache.h"
+#include "ResampleTask.h"
+
+TileCache::TileCache(QObject* parent /* = 0 */):
+    QObject(parent),
+    source(),
+    params(),
+    resultWidth(0),
+    resultHeight(0),
+    cache(TILE_CACHE_KB),
+    pending()
+{}
+
+TileCache::~TileCache() {
+    // The tasks are children of the cache; the owner waits
+    // for the thread pool before the cache is deleted
+    cancelPending();
+}
+
+void TileCache::setSource(
+    std::shared_ptr<const PlanarImage> image,
+    const ResampleParams& params
+) {
+    clear();
+    if (!image || image->isNull())
+        return;
+    source = image;
+    this->params = params;
+    // A tile is computed in one thread, the tiles run in parallel
+    this->params.numThreads = 1;
+    this->params.control = 0;
+    resampledSize(
+        params, image->width, image->height, resultWidth, resultHeight
+    );
+}
+
+void TileCache::clear() {
+    cancelPending();
+    cache.clear();
+    source.reset();
+    resultWidth = 0;
+    resultHeight = 0;
+}
+
+QRect TileCache::tileRect(int tx, int ty) const {
+    return QRect(
+        tx*TILE_SIZE, ty*TILE_SIZE, TILE_SIZE, TILE_SIZE
+    ).intersected(QRect(0, 0, resultWidth, resultHeight));
+}
+
+const QImage* TileCache::tile(int tx, int ty) {
+    if (
+        !source || tx < 0 || tx >= numTilesX() ||
+        ty < 0 || ty >= numTilesY()
+    )
+        return 0;
+    quint64 key = tileKey(tx, ty);
+    const QImage* image = cache.object(key);
+    if (image != 0 || pending.contains(key))
+        return image;
+
+    ResampleTask* task = new ResampleTask(source, params, 0, this);
+    task->region = tileRect(tx, ty);
+    connect(task, SIGNAL(finished()), this, SLOT(onTaskFinished()));
+    pending.insert(key, task);
+    QThreadPool::globalInstance()->start(task);
+    return 0;
+}
+
+void TileCache::keepOnly(const QRect& tiles) {
+    QHash<quint64, ResampleTask*>::iterator i = pending.begin();
+    while (i != pending.end()) {
+        int tx = (int)(i.key() & 0xFFFFFFFF);
+        int ty = (int)(i.key() >> 32);
+        if (tiles.contains(tx, ty)) {
+            ++i;
+        } else {
+            // The task is deleted when its finished() arrives
+            i.value()->cancel();
+            i = pending.erase(i);
+        }
+    }
+}
+
+void TileCache::cancelPending() {
+    QHash<quint64, ResampleTask*>::iterator i = pending.begin();
+    for (; i != pending.end(); ++i)
+        i.value()->cancel();
+    pending.clear();
+}
+
+void TileCache::onTaskFinished() {
+    ResampleTask* task = qobject_cast<ResampleTask*>(sender());
+    if (task == 0)
+        return;
+    task->deleteLater();
+    int tx = task->region.x()/TILE_SIZE;
+    int ty = task->region.y()/TILE_SIZE;
+    quint64 key = tileKey(tx, ty);
+    // The tasks of the previous sources were cancelled
+    // and removed from pending
+    if (pending.value(key) != task)
+        return;
+    pending.remove(key);
+    if (!task->ok)
+        return;
+    QImage* image = new QImage(task->resultImage);
+    // The cost in KiB; byteCount is deprecated and sizeInBytes
+    // appeared only in Qt 5.10
+    qint64 bytes = (qint64) image->bytesPerLine()*image->height();
+    cache.insert(key, image, (int) (bytes/1024) + 1);
+    emit tileReady(task->region);
+}
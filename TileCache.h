@@ -0,0 +1,81 @@
+#ifndef TILE_CACHE_H
+#define TILE_CACHE_H
+
+#include <memory>
+#include <QObject>
+#include <QCache>
+#include <QHash>
+#include <QImage>
+#include <QRect>
+#include "PlanarImage.h"
+#include "Resampler.h"
+
+class ResampleTask;
+
+// Side of the square tiles of the virtual result, pixels
+const int TILE_SIZE = 256;
+
+// Default memory of the cached tiles, KB
+const int TILE_CACHE_KB = 256*1024;
+
+// Tiles of the virtual result of a method (the local ones,
+// hasLocalRegions, are cheap): the result is never computed entirely, a tile
+// is computed by resampleRegion in the thread pool when it is asked
+// for the first time and kept in the LRU cache. The tiles are the same
+// as the parts of the whole result, so they have no seams.
+// tileReady() is emitted with the rectangle of a tile added to the cache
+class TileCache: public QObject
+{
+    Q_OBJECT
+public:
+    explicit TileCache(QObject* parent = 0);
+    ~TileCache();
+
+    // The new virtual result; the tiles of the previous one are dropped
+    void setSource(
+        std::shared_ptr<const PlanarImage> image,
+        const ResampleParams& params
+    );
+    void clear();
+    bool isNull() const { return !source; }
+
+    // Size of the virtual result
+    int width() const { return resultWidth; }
+    int height() const { return resultHeight; }
+    int numTilesX() const { return (resultWidth + TILE_SIZE - 1)/TILE_SIZE; }
+    int numTilesY() const {
+        return (resultHeight + TILE_SIZE - 1)/TILE_SIZE;
+    }
+    QRect tileRect(int tx, int ty) const;
+
+    // The tile (tx, ty), 0 if it is not computed yet: then it is
+    // scheduled. The pointer is valid until the next call
+    const QImage* tile(int tx, int ty);
+
+    // The scheduled tiles outside of the rectangle of tile indices
+    // are cancelled (they are not visible any more)
+    void keepOnly(const QRect& tiles);
+
+    void setCapacity(int kilobytes) { cache.setMaxCost(kilobytes); }
+
+signals:
+    void tileReady(const QRect& rect);
+
+private slots:
+    void onTaskFinished();
+
+private:
+    std::shared_ptr<const PlanarImage> source;
+    ResampleParams params;
+    int resultWidth;
+    int resultHeight;
+    QCache<quint64, QImage> cache;          // Cost in KB
+    QHash<quint64, ResampleTask*> pending;  // Tiles being computed
+
+    static quint64 tileKey(int tx, int ty) {
+        return ((quint64) (unsigned) ty << 32) | (quint64) (unsigned) tx;
+    }
+    void cancelPending();
+};
+
+#endif
@@ -0,0 +1,455 @@
+// imview-cli: the batch resizer. Every file of the list is loaded,
+// processed by one of the engines and written to the output directory;
+// the files are processed in parallel, the threads of processors are
+// divided between the images processed at once
+//
+//     imview-cli -m spline-c1 -z 4 -o out/ a.png b.jpg ...
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+#include <vector>
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QFileInfo>
+#include <QFile>
+#include <QHash>
+#include <QImage>
+#include "Resampler.h"
+#include "ResampleStream.h"
+#include "ImageConvert.h"
+#include "QImagePlanes.h"
+
+struct CliOptions {
+    ResampleParams params;
+    QString outputDir;      // Empty -- the directory of the source
+    QString suffix;         // Added to the base name of the source
+    QString format;         // Empty -- the format of the source (png
+                            // if the source has no suffix)
+    int quality;            // -1 -- default quality of the format
+    // The part of the result, cropWidth == 0 -- the whole result
+    int cropX;
+    int cropY;
+    int cropWidth;
+    int cropHeight;
+    bool stream;            // PPM files processed by strips of rows
+};
+
+// The path of the result of the source file
+static QString resultPath(
+    const CliOptions& options, const QString& path, const QString& format
+) {
+    QFileInfo info(path);
+    QString dir = options.outputDir;
+    if (dir.isEmpty())
+        dir = info.absolutePath();
+    return QDir(dir).filePath(
+        info.completeBaseName() + options.suffix + "." + format
+    );
+}
+
+// The format of the result of the source file
+static QString resultFormat(const CliOptions& options, const QString& path) {
+    if (options.stream)
+        return "ppm";
+    QString format = options.format;
+    if (format.isEmpty())
+        format = QFileInfo(path).suffix();
+    if (format.isEmpty())
+        format = "png";
+    return format;
+}
+
+// The source and the result are binary PPM files, they are never
+// in memory entirely (resampleStream)
+static bool processStream(
+    const CliOptions& options, const QString& path,
+    QString& outputPath, QString& message
+) {
+    const ResampleParams& params = options.params;
+    PpmRowSource source;
+    if (!source.open(QFile::encodeName(path).constData())) {
+        message = "cannot read the image (binary PPM is expected)";
+        return false;
+    }
+    int resultWidth, resultHeight;
+    resampledSize(
+        params, source.width(), source.height(), resultWidth, resultHeight
+    );
+    if (resultWidth <= 0 || resultHeight <= 0) {
+        message = "the result is empty";
+        return false;
+    }
+    outputPath = resultPath(options, path, resultFormat(options, path));
+    PpmRowSink sink;
+    if (
+        !sink.open(
+            QFile::encodeName(outputPath).constData(),
+            resultWidth, resultHeight
+        )
+    ) {
+        message = "cannot write " + outputPath;
+        return false;
+    }
+    if (
+        !resampleStream(
+            source.width(), source.height(), source, sink, params
+        ) ||
+        !sink.close()
+    ) {
+        message = "cannot process the image into " + outputPath;
+        return false;
+    }
+    return true;
+}
+
+// The processed image of the file; false and the message on failure
+static bool processFile(
+    const CliOptions& options, const QString& path,
+    QString& outputPath, QString& message
+) {
+    if (options.stream)
+        return processStream(options, path, outputPath, message);
+    const ResampleParams& params = options.params;
+    QImage src;
+    if (!src.load(path)) {
+        message = "cannot read the image";
+        return false;
+    }
+    int resultWidth, resultHeight;
+    resampledSize(
+        params, src.width(), src.height(), resultWidth, resultHeight
+    );
+    if (resultWidth <= 0 || resultHeight <= 0) {
+        message = "the result is empty";
+        return false;
+    }
+
+    QImage result;
+    if (options.cropWidth > 0) {
+        // Only the source pixels the part depends on are converted
+        // and processed
+        int srcX0, srcY0, srcWidth, srcHeight;
+        if (
+            !resampleRegionSource(
+                params, src.width(), src.height(),
+                options.cropX, options.cropY,
+                options.cropWidth, options.cropHeight,
+                srcX0, srcY0, srcWidth, srcHeight
+            )
+        ) {
+            message = "the crop is not inside the result";
+            return false;
+        }
+        PlanarImage part;
+        imageToPlanes(
+            src.copy(srcX0, srcY0, srcWidth, srcHeight), part,
+            params.numThreads
+        );
+        int imageWidth = src.width();
+        int imageHeight = src.height();
+        src = QImage();
+        PlanarImage region;
+        if (
+            !resampleRegion(
+                part, srcX0, srcY0, imageWidth, imageHeight,
+                options.cropX, options.cropY,
+                options.cropWidth, options.cropHeight, region, params
+            )
+        ) {
+            message = "the result is empty";
+            return false;
+        }
+        result = planesToImage(region, params.numThreads);
+    } else if (params.method == METHOD_BILINEAR8) {
+        // The scanlines are interpolated directly
+        QImage rgbImage = src.convertToFormat(QImage::Format_RGB32);
+        result = QImage(resultWidth, resultHeight, QImage::Format_RGB32);
+        if (
+            result.isNull() ||
+            !resamplePixels(
+                rgbImage.width(), rgbImage.height(),
+                rgbImage.constBits(), rgbImage.bytesPerLine(),
+                PIXELS_XRGB32,
+                result.bits(), result.bytesPerLine(), PIXELS_XRGB32,
+                params
+            )
+        ) {
+            message = "the result is empty";
+            return false;
+        }
+    } else {
+        PlanarImage image;
+        imageToPlanes(src, image, params.numThreads);
+        src = QImage();         // The source is not needed any more
+        PlanarImage processed;
+        if (!resampleImage(image, processed, params)) {
+            message = "the result is empty";
+            return false;
+        }
+        result = planesToImage(processed, params.numThreads);
+    }
+
+    outputPath = resultPath(options, path, resultFormat(options, path));
+    if (!result.save(outputPath, 0, options.quality)) {
+        message = "cannot write " + outputPath;
+        return false;
+    }
+    return true;
+}
+
+// The worker: takes the next file of the list until the list is over
+static void processFiles(
+    const CliOptions& options, const QStringList& files,
+    std::atomic<int>& nextFile, std::atomic<int>& numFailed
+) {
+    while (true) {
+        int i = nextFile.fetch_add(1);
+        if (i >= files.size())
+            break;
+        const QString& path = files[i];
+        std::chrono::steady_clock::time_point t0 =
+            std::chrono::steady_clock::now();
+        QString outputPath, message;
+        if (processFile(options, path, outputPath, message)) {
+            double t = std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - t0
+            ).count();
+            fprintf(
+                stdout, "%s -> %s (%.3f s)\n",
+                path.toLocal8Bit().constData(),
+                outputPath.toLocal8Bit().constData(), t
+            );
+        } else {
+            fprintf(
+                stderr, "%s: %s\n",
+                path.toLocal8Bit().constData(),
+                message.toLocal8Bit().constData()
+            );
+            ++numFailed;
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("imview-cli");
+
+    QString methods;
+    for (int m = 0; m < NUM_RESAMPLE_METHODS; ++m) {
+        methods += QString("\n  %1 -- %2").arg(
+            resampleMethodName(m), resampleMethodDescription(m)
+        );
+    }
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        "Resizes and filters the images by the engines of ImView."
+    );
+    parser.addHelpOption();
+    QCommandLineOption methodOption(
+        QStringList() << "m" << "method",
+        "Method of processing:" + methods, "method", "spline-c1"
+    );
+    QCommandLineOption zoomOption(
+        QStringList() << "z" << "zoom", "Zoom coefficient.", "zoom", "4"
+    );
+    QCommandLineOption sigmaOption(
+        QStringList() << "s" << "sigma",
+        "Sigma of the Gaussian filter in pixels.", "sigma", "1"
+    );
+    QCommandLineOption radiusOption(
+        QStringList() << "r" << "radius",
+        "Maximal size of the truncated Gaussian kernel.", "radius", "5"
+    );
+    QCommandLineOption contrastOption(
+        QStringList() << "c" << "contrast",
+        "Sigmoid coefficient of the high-pass filter.", "contrast", "1"
+    );
+    QCommandLineOption toleranceOption(
+        QStringList() << "tolerance",
+        "C2 splines: solve the lines by windows with this error"
+        " (0 -- the exact splines of the whole lines).", "error", "0"
+    );
+    QCommandLineOption outputOption(
+        QStringList() << "o" << "output-dir",
+        "Directory of the results (the directory of a source"
+        " by default).", "dir"
+    );
+    QCommandLineOption suffixOption(
+        QStringList() << "suffix",
+        "Suffix added to the names of the results (_<method> by default).",
+        "suffix"
+    );
+    QCommandLineOption formatOption(
+        QStringList() << "f" << "format",
+        "Format of the results: png, jpg, ... (the format of a source"
+        " by default, png for a source without suffix).", "format"
+    );
+    QCommandLineOption qualityOption(
+        QStringList() << "q" << "quality",
+        "Quality 0..100 of the compressed formats.", "quality", "-1"
+    );
+    QCommandLineOption cropOption(
+        QStringList() << "crop",
+        "Only the part x,y,width,height of the result (its pixels are"
+        " the same as in the whole result).", "x,y,w,h"
+    );
+    QCommandLineOption streamOption(
+        QStringList() << "stream",
+        "Process binary PPM images by strips of rows, without loading"
+        " them entirely (the local methods; the results are PPM)."
+    );
+    QCommandLineOption jobsOption(
+        QStringList() << "j" << "jobs",
+        "Number of images processed at once (the number of processors"
+        " by default).", "jobs", "0"
+    );
+    QCommandLineOption threadsOption(
+        QStringList() << "t" << "threads",
+        "Threads of one image (the processors divided between the jobs"
+        " by default).", "threads", "0"
+    );
+    parser.addOption(methodOption);
+    parser.addOption(zoomOption);
+    parser.addOption(sigmaOption);
+    parser.addOption(radiusOption);
+    parser.addOption(contrastOption);
+    parser.addOption(toleranceOption);
+    parser.addOption(outputOption);
+    parser.addOption(suffixOption);
+    parser.addOption(formatOption);
+    parser.addOption(qualityOption);
+    parser.addOption(cropOption);
+    parser.addOption(streamOption);
+    parser.addOption(jobsOption);
+    parser.addOption(threadsOption);
+    parser.addPositionalArgument("files", "Images to process.", "files...");
+    parser.process(app);
+
+    CliOptions options;
+    ResampleParams& params = options.params;
+    QString methodName = parser.value(methodOption);
+    params.method = findResampleMethod(methodName.toLocal8Bit().constData());
+    if (params.method < 0) {
+        fprintf(
+            stderr, "Unknown method %s\n", methodName.toLocal8Bit().constData()
+        );
+        return 1;
+    }
+    bool ok = true, valid;
+    params.zoom = fabs(parser.value(zoomOption).toDouble(&valid));
+    ok = ok && valid && params.zoom > 0. && std::isfinite(params.zoom);
+    params.sigma = parser.value(sigmaOption).toDouble(&valid);
+    ok = ok && valid && params.sigma > 0.;
+    params.radius = parser.value(radiusOption).toInt(&valid);
+    ok = ok && valid;
+    params.contrast = parser.value(contrastOption).toDouble(&valid);
+    ok = ok && valid;
+    params.splineTolerance = parser.value(toleranceOption).toDouble(&valid);
+    ok = ok && valid && params.splineTolerance >= 0.;
+    options.quality = parser.value(qualityOption).toInt(&valid);
+    ok = ok && valid;
+    int numJobs = parser.value(jobsOption).toInt(&valid);
+    ok = ok && valid;
+    params.numThreads = parser.value(threadsOption).toInt(&valid);
+    ok = ok && valid;
+    options.cropX = options.cropY = 0;
+    options.cropWidth = options.cropHeight = 0;
+    if (parser.isSet(cropOption)) {
+        QStringList crop = parser.value(cropOption).split(',');
+        ok = ok && crop.size() == 4;
+        if (ok) {
+            bool v0, v1, v2, v3;
+            options.cropX = crop[0].toInt(&v0);
+            options.cropY = crop[1].toInt(&v1);
+            options.cropWidth = crop[2].toInt(&v2);
+            options.cropHeight = crop[3].toInt(&v3);
+            ok = v0 && v1 && v2 && v3 &&
+                options.cropWidth > 0 && options.cropHeight > 0;
+        }
+    }
+    options.stream = parser.isSet(streamOption);
+    if (!ok) {
+        fprintf(stderr, "Invalid value of an option\n");
+        return 1;
+    }
+    if (
+        options.stream &&
+        (options.cropWidth > 0 || !hasLocalRegions(params))
+    ) {
+        fprintf(stderr, "The stream needs a local method and no crop\n");
+        return 1;
+    }
+    options.outputDir = parser.value(outputOption);
+    options.format = parser.value(formatOption);
+    if (parser.isSet(suffixOption))
+        options.suffix = parser.value(suffixOption);
+    else
+        options.suffix = "_" + methodName;
+    if (options.suffix.isEmpty() && options.outputDir.isEmpty()) {
+        fprintf(stderr, "The results would replace the sources\n");
+        return 1;
+    }
+    if (!options.outputDir.isEmpty() && !QDir().mkpath(options.outputDir)) {
+        fprintf(
+            stderr, "Cannot create %s\n",
+            options.outputDir.toLocal8Bit().constData()
+        );
+        return 1;
+    }
+
+    QStringList files = parser.positionalArguments();
+    if (files.isEmpty())
+        parser.showHelp(1);
+
+    // The sources of the same base name in different directories
+    // would write the same result (the jobs at once)
+    QHash<QString, QString> sources;
+    for (int i = 0; i < files.size(); ++i) {
+        QString output = QFileInfo(
+            resultPath(options, files[i], resultFormat(options, files[i]))
+        ).absoluteFilePath();
+        if (sources.contains(output)) {
+            fprintf(
+                stderr, "%s and %s have the same result %s\n",
+                sources.value(output).toLocal8Bit().constData(),
+                files[i].toLocal8Bit().constData(),
+                output.toLocal8Bit().constData()
+            );
+            return 1;
+        }
+        sources.insert(output, files[i]);
+    }
+
+    // The jobs take the files one by one; every job uses its share
+    // of processors unless the number of threads is given
+    if (numJobs <= 0)
+        numJobs = defaultNumThreads();
+    if (numJobs > files.size())
+        numJobs = files.size();
+    if (params.numThreads <= 0) {
+        params.numThreads = defaultNumThreads()/numJobs;
+        if (params.numThreads < 1)
+            params.numThreads = 1;
+    }
+
+    std::atomic<int> nextFile(0);
+    std::atomic<int> numFailed(0);
+    std::vector<std::thread> jobs;
+    jobs.reserve(numJobs);
+    for (int j = 0; j < numJobs; ++j) {
+        jobs.push_back(std::thread(
+            processFiles, std::cref(options), std::cref(files),
+            std::ref(nextFile), std::ref(numFailed)
+        ));
+    }
+    for (int j = 0; j < numJobs; ++j)
+        jobs[j].join();
+
+    return (numFailed > 0)? 1 : 0;
+}
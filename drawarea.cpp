@@ -1,18 +1,94 @@
+#include <cmath>
 #include <QtGui>
 #include "drawarea.h"
 #include "mainwindow.h"
+#include "TileCache.h"
 
 DrawArea::DrawArea(QWidget *parent) :
     QWidget(parent),
     bgColor(Qt::darkGray),
     xSize(0),
-    ySize(0)
+    ySize(0),
+    viewOrigin(0., 0.),
+    viewScale(1.),
+    tiles(0),
+    pyramid(),
+    dragging(false),
+    dragPos()
 {
     setAttribute(Qt::WA_StaticContents); // for optimizing painting events
+    // Every pixel is painted, so scroll() and the exposed rectangles
+    // need not erase the background first
+    setAttribute(Qt::WA_OpaquePaintEvent);
     drawArea = this;
+    tiles = new TileCache(this);
+    connect(
+        tiles, SIGNAL(tileReady(const QRect&)),
+        this, SLOT(onTileReady(const QRect&))
+    );
 }
 
-void DrawArea::paintEvent(QPaintEvent* /* event */)
+void DrawArea::resetView() {
+    viewOrigin = QPointF(0., 0.);
+    viewScale = 1.;
+    update();
+}
+
+void DrawArea::fitView() {
+    int w = 0, h = 0;
+    if (!tiles->isNull()) {
+        w = tiles->width();
+        h = tiles->height();
+    } else if (shownImage() != 0) {
+        w = shownImage()->width();
+        h = shownImage()->height();
+    }
+    viewOrigin = QPointF(0., 0.);
+    viewScale = 1.;
+    while (
+        viewScale > MIN_VIEW_SCALE &&
+        (w*viewScale > width() || h*viewScale > height())
+    )
+        viewScale /= 2.;
+    update();
+}
+
+void DrawArea::showTiles(
+    std::shared_ptr<const PlanarImage> image,
+    const ResampleParams& params
+) {
+    tiles->setSource(image, params);
+    update();
+}
+
+void DrawArea::clearTiles() {
+    if (tiles->isNull())
+        return;
+    tiles->clear();
+    update();
+}
+
+bool DrawArea::hasTiles() const {
+    return !tiles->isNull();
+}
+
+const QImage* DrawArea::shownImage() const {
+    if (mainWindow->previewImage != 0)
+        return mainWindow->previewImage;
+    if (mainWindow->modifiedImage != 0)
+        return mainWindow->modifiedImage;
+    return mainWindow->image;
+}
+
+QRect DrawArea::toWidget(const QRectF& rect) const {
+    return QRectF(
+        (rect.x() - viewOrigin.x())*viewScale,
+        (rect.y() - viewOrigin.y())*viewScale,
+        rect.width()*viewScale, rect.height()*viewScale
+    ).toAlignedRect();
+}
+
+void DrawArea::paintEvent(QPaintEvent* event)
 {
     if (
         xSize == 0 || ySize == 0 ||
@@ -22,14 +98,132 @@ void DrawArea::paintEvent(QPaintEvent* /* event */)
         ySize = height();
     }
 
+    // Only the exposed rectangle is painted: after scroll() it is
+    // the strip that came into the view
+    QRect exposed = event->rect();
     QPainter painter(this);
-    painter.setRenderHint(QPainter::Antialiasing);
-    painter.fillRect(0, 0, width(), height(), bgColor);
+    painter.fillRect(exposed, bgColor);
 
-    if (mainWindow->modifiedImage != 0)
-        painter.drawImage(0, 0, *(mainWindow->modifiedImage));
-    else if (mainWindow->image != 0)
-        painter.drawImage(0, 0, *(mainWindow->image));
+    QRectF view(
+        viewOrigin.x() + exposed.x()/viewScale,
+        viewOrigin.y() + exposed.y()/viewScale,
+        exposed.width()/viewScale, exposed.height()/viewScale
+    );
+    painter.scale(viewScale, viewScale);
+    painter.translate(-viewOrigin);
+    if (!tiles->isNull()) {
+        paintTiles(painter, view);
+        return;
+    }
+    const QImage* image = shownImage();
+    if (image == 0) {
+        pyramid.clear();
+        return;
+    }
+    // The levels are made again only for another image
+    pyramid.setImage(*image);
+    paintImage(painter, view, viewScale);
+}
+
+void DrawArea::paintImage(
+    QPainter& painter, const QRectF& view, double scale
+) {
+    int level = pyramid.levelFor(scale);
+    const QPixmap& pixmap = pyramid.pixmap(level);
+    double fx = (double) pixmap.width() / (double) pyramid.width();
+    double fy = (double) pixmap.height() / (double) pyramid.height();
+    // The whole pixels of the level under the exposed rectangle
+    QRect source = QRectF(
+        view.x()*fx, view.y()*fy, view.width()*fx, view.height()*fy
+    ).toAlignedRect() & pixmap.rect();
+    if (source.isEmpty())
+        return;
+    if (level > 0 || scale < 1.)
+        painter.setRenderHint(QPainter::SmoothPixmapTransform);
+    painter.drawPixmap(
+        QRectF(
+            source.x()/fx, source.y()/fy,
+            source.width()/fx, source.height()/fy
+        ),
+        pixmap, QRectF(source)
+    );
+}
+
+void DrawArea::paintTiles(QPainter& painter, const QRectF& view) {
+    const QImage* source = mainWindow->image;
+    double sx = 0., sy = 0.;
+    if (source != 0) {
+        sx = (double) source->width() / (double) tiles->width();
+        sy = (double) source->height() / (double) tiles->height();
+    }
+    if (viewScale < 1.) {
+        // A reduced view would need the tiles of a large part
+        // of the result: the source is drawn from its pyramid
+        // and no tile is computed
+        tiles->keepOnly(QRect());
+        if (source == 0) {
+            pyramid.clear();
+            return;
+        }
+        pyramid.setImage(*source);
+        painter.scale(1./sx, 1./sy);
+        paintImage(
+            painter,
+            QRectF(
+                view.x()*sx, view.y()*sy, view.width()*sx, view.height()*sy
+            ),
+            viewScale/sx
+        );
+        return;
+    }
+
+    QRectF result(0., 0., tiles->width(), tiles->height());
+    QRectF part = view & result;
+    if (!part.isEmpty()) {
+        int tx0 = (int) floor(part.left()/TILE_SIZE);
+        int ty0 = (int) floor(part.top()/TILE_SIZE);
+        int tx1 = (int) ceil(part.right()/TILE_SIZE);
+        int ty1 = (int) ceil(part.bottom()/TILE_SIZE);
+
+        for (int ty = ty0; ty < ty1; ++ty) {
+            for (int tx = tx0; tx < tx1; ++tx) {
+                QRect r = tiles->tileRect(tx, ty);
+                const QImage* tile = tiles->tile(tx, ty);
+                if (tile != 0) {
+                    painter.drawImage(r.topLeft(), *tile);
+                } else if (source != 0) {
+                    // The tile is being computed
+                    painter.drawImage(
+                        QRectF(r), *source,
+                        QRectF(
+                            r.x()*sx, r.y()*sy,
+                            r.width()*sx, r.height()*sy
+                        )
+                    );
+                }
+            }
+        }
+    }
+
+    // The tiles that went out of the whole view are not computed
+    QRectF whole = QRectF(
+        viewOrigin, QSizeF(width()/viewScale, height()/viewScale)
+    ) & result;
+    QRect visible;
+    if (!whole.isEmpty()) {
+        int tx0 = (int) floor(whole.left()/TILE_SIZE);
+        int ty0 = (int) floor(whole.top()/TILE_SIZE);
+        visible = QRect(
+            tx0, ty0,
+            (int) ceil(whole.right()/TILE_SIZE) - tx0,
+            (int) ceil(whole.bottom()/TILE_SIZE) - ty0
+        );
+    }
+    tiles->keepOnly(visible);
+}
+
+void DrawArea::onTileReady(const QRect& rect) {
+    update(toWidget(QRectF(rect)));
 }
 
 void DrawArea::resizeEvent(QResizeEvent* /* event */) {
@@ -47,3 +241,57 @@ void DrawArea::resizeEvent(QResizeEvent* /* event */) {
 
     }
 }
+
+void DrawArea::mousePressEvent(QMouseEvent* event) {
+    if (event->button() != Qt::LeftButton)
+        return;
+    dragging = true;
+    dragPos = event->pos();
+    setCursor(QCursor(Qt::ClosedHandCursor));
+}
+
+void DrawArea::mouseMoveEvent(QMouseEvent* event) {
+    if (!dragging)
+        return;
+    QPoint d = event->pos() - dragPos;
+    dragPos = event->pos();
+    viewOrigin -= QPointF(d)/viewScale;
+    // The shown pixels are moved, only the uncovered strips are painted
+    scroll(d.x(), d.y());
+}
+
+void DrawArea::mouseReleaseEvent(QMouseEvent* event) {
+    if (event->button() != Qt::LeftButton || !dragging)
+        return;
+    dragging = false;
+    unsetCursor();
+}
+
+void DrawArea::wheelEvent(QWheelEvent* event) {
+    int delta = event->angleDelta().y();
+    if (delta == 0)
+        return;
+    double scale = (delta > 0)? viewScale*2. : viewScale/2.;
+    if (scale < MIN_VIEW_SCALE || scale > MAX_VIEW_SCALE)
+        return;
+    // The point under the cursor stays in place
+    QPointF p = QPointF(event->pos());
+    viewOrigin += p/viewScale - p/scale;
+    viewScale = scale;
+    // The origin falls on a pixel of the widget, so the strips painted
+    // after scroll() join the moved pixels exactly
+    viewOrigin = QPointF(
+        floor(viewOrigin.x()*scale + 0.5)/scale,
+        floor(viewOrigin.y()*scale + 0.5)/scale
+    );
+    update();
+}
+
+void DrawArea::mouseDoubleClickEvent(QMouseEvent* event) {
+    if (event->button() != Qt::LeftButton)
+        return;
+    if (viewScale == 1.)
+        fitView();
+    else
+        resetView();
+}
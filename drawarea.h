@@ -1,10 +1,25 @@
 #ifndef DRAWAREA_H
 #define DRAWAREA_H
 
+#include <memory>
 #include <QWidget>
 #include <QColor>
 #include <QImage>
+#include <QPoint>
+#include <QPointF>
+#include <QRect>
+#include <QRectF>
 #include "RealPixel.h"
+#include "PlanarImage.h"
+#include "Resampler.h"
+#include "DisplayPyramid.h"
+
+class TileCache;
+
+// Scales of the view, powers of 2; the smallest one
+// is that of the last level of DisplayPyramid
+const double MIN_VIEW_SCALE = 1./64.;
+const double MAX_VIEW_SCALE = 8.;
 
 class DrawArea: public QWidget
 {
@@ -14,12 +29,58 @@ public:
     int xSize;
     int ySize;
 
+    // The view: the point of the image at the top left corner
+    // of the widget and the widget pixels per image pixel.
+    // The image is dragged by the mouse and zoomed by the wheel,
+    // the double click fits it to the widget or returns to 1:1
+    QPointF viewOrigin;
+    double viewScale;
+
     DrawArea(QWidget *parent = 0);
 
+    void resetView();
+    // The largest power of 2 scale with the whole image visible
+    void fitView();
+
+    // The result of the method is shown without computing it: only
+    // the visible tiles are computed, in the background (see
+    // TileCache). Until a tile is ready
+    // the scaled source image is drawn in its place; the reduced
+    // views (scale < 1) show the source only, so zooming out does not
+    // compute the tiles of the whole result
+    void showTiles(
+        std::shared_ptr<const PlanarImage> image,
+        const ResampleParams& params
+    );
+    void clearTiles();
+    bool hasTiles() const;
 
 protected:
     void paintEvent(QPaintEvent *event);
     void resizeEvent(QResizeEvent *event);
+    void mousePressEvent(QMouseEvent *event);
+    void mouseMoveEvent(QMouseEvent *event);
+    void mouseReleaseEvent(QMouseEvent *event);
+    void mouseDoubleClickEvent(QMouseEvent *event);
+    void wheelEvent(QWheelEvent *event);
+
+private slots:
+    void onTileReady(const QRect& rect);
+
+private:
+    TileCache* tiles;
+    DisplayPyramid pyramid;     // Of the shown image
+    bool dragging;
+    QPoint dragPos;     // Last position of the mouse while dragging
+
+    // The image of mainWindow that is shown, 0 -- none
+    const QImage* shownImage() const;
+    // The rectangle of the image in the pixels of the widget
+    QRect toWidget(const QRectF& rect) const;
+    // view is the exposed rectangle in the pixels of the image,
+    // scale is the widget pixels per image pixel
+    void paintImage(QPainter& painter, const QRectF& view, double scale);
+    void paintTiles(QPainter& painter, const QRectF& view);
 };
 
 #endif // DRAWAREA_H
@@ -0,0 +1,28 @@
+# Image processing engines (see Resampler.h): plain C++ without Qt,
+# built as the library imview-engines.pro and compiled into the GUI
+# and the command-line tool
+
+CONFIG += c++11 thread
+
+INCLUDEPATH += $$PWD
+
+SOURCES += $$PWD/RealPixel.cpp $$PWD/PlanarImage.cpp \
+        $$PWD/ResamplePlan.cpp $$PWD/GaussFilter.cpp \
+        $$PWD/PixelMixing.cpp $$PWD/Bicubic.cpp $$PWD/Bilinear.cpp \
+        $$PWD/Bilinear8.cpp $$PWD/ImageConvert.cpp \
+        $$PWD/PixelFilters.cpp $$PWD/Resampler.cpp \
+        $$PWD/ResampleStream.cpp \
+        $$PWD/CubicInterpol/cubint.cpp $$PWD/CubicInterpol/bandmatrix.cpp \
+        $$PWD/CubicInterpol/bspline.cpp
+
+HEADERS += $$PWD/RealPixel.h $$PWD/PlanarImage.h \
+        $$PWD/ResamplePlan.h $$PWD/GaussFilter.h \
+        $$PWD/PixelMixing.h $$PWD/Bicubic.h $$PWD/Bilinear.h \
+        $$PWD/Bilinear8.h $$PWD/ImageConvert.h \
+        $$PWD/PixelFilters.h $$PWD/Resampler.h $$PWD/ResampleControl.h \
+        $$PWD/ResampleStream.h \
+        $$PWD/CubicInterpol/cubint.h $$PWD/CubicInterpol/bandmatrix.h \
+        $$PWD/CubicInterpol/R2Graph.h $$PWD/CubicInterpol/bspline.h \
+        $$PWD/CubicInterpol/vectorspline.h
+
+CONFIG(release, debug|release): DEFINES += NDEBUG
@@ -0,0 +1,406 @@
+// imview-engines-test: the checks of the engines without Qt.
+// The parts of the result must be the parts of the whole result:
+//  - resampleRegion equals the crop of resampleImage for every method,
+//    also when only the source window of resampleRegionSource is given;
+//  - the C2 splines solved by windows differ from the exact ones
+//    by at most splineTolerance;
+//  - resampleStream writes the rows of resampleImage;
+//  - the truncated and the recursive Gaussian filters are the same
+//    filter where GAUSS_AUTO switches between them;
+//  - the export of the imported 8-bit pixels gives the same pixels
+//    for every layout and width 1..100, the planes with NaN give 0;
+//  - Bilinear8 is at most 1 of 255 from the bilinear filter on floats.
+// With CONFIG+=scalar the engines are built without their SSE2
+// kernels, so the same checks cover the scalar code.
+// Prints the failed checks; the exit code is 1 if one failed
+//
+//     imview-engines-test
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "Resampler.h"
+#include "ImageConvert.h"
+#include "GaussFilter.h"
+#include "ResampleStream.h"
+
+static int numChecks = 0;
+static int numFailures = 0;
+
+static void check(
+    bool ok, const char* what, const ResampleParams& params
+) {
+    ++numChecks;
+    if (ok)
+        return;
+    ++numFailures;
+    fprintf(
+        stderr, "FAILED %s: %s, zoom %g\n",
+        what, resampleMethodName(params.method), params.zoom
+    );
+}
+
+// Random pixels in [0, 1], the same for the same seed
+static void randomImage(
+    int width, int height, unsigned seed, PlanarImage& image
+) {
+    image.create(width, height);
+    srand(seed);
+    for (int c = 0; c < NUM_PLANES; ++c) {
+        for (int y = 0; y < height; ++y) {
+            float* row = image.row(c, y);
+            for (int x = 0; x < width; ++x)
+                row[x] = (float) rand() / (float) RAND_MAX;
+        }
+    }
+}
+
+// The region is the same as the part of the whole result at (x0, y0)
+static bool sameAsCrop(
+    const PlanarImage& whole, const PlanarImage& region, int x0, int y0
+) {
+    for (int c = 0; c < NUM_PLANES; ++c) {
+        for (int y = 0; y < region.height; ++y) {
+            if (
+                memcmp(
+                    whole.row(c, y0 + y) + x0, region.row(c, y),
+                    region.width*sizeof(float)
+                ) != 0
+            )
+                return false;
+        }
+    }
+    return true;
+}
+
+// Random regions of the result: from the whole source and, for
+// the local methods, from the source window only
+static void checkRegions(
+    const PlanarImage& image, const ResampleParams& params
+) {
+    PlanarImage whole;
+    if (!resampleImage(image, whole, params))
+        return;
+    for (int i = 0; i < 6; ++i) {
+        int w = 1 + rand()%whole.width;
+        int h = 1 + rand()%whole.height;
+        int x0 = rand()%(whole.width - w + 1);
+        int y0 = rand()%(whole.height - h + 1);
+        PlanarImage region;
+        check(
+            resampleRegion(image, x0, y0, w, h, region, params) &&
+            sameAsCrop(whole, region, x0, y0),
+            "region", params
+        );
+        if (!hasLocalRegions(params))
+            continue;
+
+        int srcX0, srcY0, srcWidth, srcHeight;
+        resampleRegionSource(
+            params, image.width, image.height, x0, y0, w, h,
+            srcX0, srcY0, srcWidth, srcHeight
+        );
+        PlanarImage part(srcWidth, srcHeight);
+        for (int c = 0; c < NUM_PLANES; ++c) {
+            for (int y = 0; y < srcHeight; ++y) {
+                memcpy(
+                    part.row(c, y), image.row(c, srcY0 + y) + srcX0,
+                    srcWidth*sizeof(float)
+                );
+            }
+        }
+        check(
+            resampleRegion(
+                part, srcX0, srcY0, image.width, image.height,
+                x0, y0, w, h, region, params
+            ) &&
+            sameAsCrop(whole, region, x0, y0),
+            "region of the source window", params
+        );
+    }
+}
+
+// The windowed C2 splines against the exact ones
+static void checkTolerance(
+    const PlanarImage& image, const ResampleParams& params
+) {
+    ResampleParams exactParams = params;
+    exactParams.splineTolerance = 0.;
+    PlanarImage exact, windowed;
+    if (
+        !resampleImage(image, exact, exactParams) ||
+        !resampleImage(image, windowed, params)
+    )
+        return;
+    double maxError = 0.;
+    for (int c = 0; c < NUM_PLANES; ++c) {
+        for (int y = 0; y < exact.height; ++y) {
+            const float* e = exact.row(c, y);
+            const float* w = windowed.row(c, y);
+            for (int x = 0; x < exact.width; ++x)
+                maxError = fmax(maxError, fabs((double) w[x] - e[x]));
+        }
+    }
+    check(maxError <= params.splineTolerance, "spline tolerance", params);
+}
+
+// The rows of the source image, in the order of resampleStream
+class ImageRowSource: public RowSource {
+public:
+    explicit ImageRowSource(const PlanarImage& source):
+        image(source),
+        nextRow(0)
+    {}
+
+    bool readRow(int y, float* const* row) {
+        if (y != nextRow)
+            return false;
+        ++nextRow;
+        for (int c = 0; c < NUM_PLANES; ++c)
+            memcpy(row[c], image.row(c, y), image.width*sizeof(float));
+        return true;
+    }
+
+private:
+    const PlanarImage& image;
+    int nextRow;
+};
+
+// The rows of the result collected into an image
+class ImageRowSink: public RowSink {
+public:
+    ImageRowSink(int width, int height):
+        image(width, height),
+        nextRow(0)
+    {}
+
+    bool writeRow(int y, const float* const* row) {
+        if (y != nextRow)
+            return false;
+        ++nextRow;
+        for (int c = 0; c < NUM_PLANES; ++c)
+            memcpy(image.row(c, y), row[c], image.width*sizeof(float));
+        return true;
+    }
+
+    PlanarImage image;
+    int nextRow;
+};
+
+static void checkStream(
+    const PlanarImage& image, const ResampleParams& params
+) {
+    PlanarImage whole;
+    if (!resampleImage(image, whole, params))
+        return;
+    ImageRowSource source(image);
+    ImageRowSink sink(whole.width, whole.height);
+    bool ok = resampleStream(
+        image.width, image.height, source, sink, params
+    );
+    if (!hasLocalRegions(params)) {
+        check(!ok, "stream of a global method", params);
+        return;
+    }
+    check(
+        ok && sink.nextRow == whole.height &&
+        sameAsCrop(whole, sink.image, 0, 0),
+        "stream", params
+    );
+}
+
+// GAUSS_AUTO changes the method at GAUSS_RECURSIVE_SIGMA: the results
+// must differ only by the error of the recursive approximation
+static void checkGaussSwitch(const PlanarImage& image) {
+    ResampleParams params;
+    params.method = METHOD_GAUSS;
+    params.sigma = GAUSS_RECURSIVE_SIGMA;
+    params.zoom = 1.;
+    int maxSize = 1000;
+    PlanarImage truncated, recursive;
+    gaussFilter(
+        image, truncated, params.sigma, maxSize, GAUSS_TRUNCATED
+    );
+    gaussFilter(
+        image, recursive, params.sigma, maxSize, GAUSS_RECURSIVE
+    );
+    double maxDiff = 0.;
+    for (int c = 0; c < NUM_PLANES; ++c) {
+        for (int y = 0; y < image.height; ++y) {
+            const float* t = truncated.row(c, y);
+            const float* r = recursive.row(c, y);
+            for (int x = 0; x < image.width; ++x)
+                maxDiff = fmax(maxDiff, fabs((double) t[x] - r[x]));
+        }
+    }
+    check(maxDiff < 0.01, "truncated and recursive Gauss", params);
+}
+
+static void checkPixels(
+    bool ok, const char* what, int layout, int width
+) {
+    ++numChecks;
+    if (ok)
+        return;
+    ++numFailures;
+    fprintf(stderr, "FAILED %s: layout %d, width %d\n", what, layout, width);
+}
+
+// Bytes per pixel of the layouts of ImageConvert.h
+static const int pixelBytes[] = {4, 3, 1};
+
+// Random bytes; the alpha of XRGB32 is 0xFF, it is not kept
+static void randomPixels(
+    int width, int height, int bytesPerLine, int layout,
+    std::vector<unsigned char>& bits
+) {
+    bits.assign(bytesPerLine*height, 0);
+    for (int y = 0; y < height; ++y) {
+        unsigned char* row = bits.data() + y*bytesPerLine;
+        for (int i = 0; i < width*pixelBytes[layout]; ++i)
+            row[i] = (unsigned char) rand();
+        if (layout != PIXELS_XRGB32)
+            continue;
+        for (int x = 0; x < width; ++x) {
+            unsigned int p;
+            memcpy(&p, row + 4*x, 4);
+            p |= 0xFF000000u;
+            memcpy(row + 4*x, &p, 4);
+        }
+    }
+}
+
+// The pixels of the rows, without the padding
+static bool samePixels(
+    const std::vector<unsigned char>& a, const std::vector<unsigned char>& b,
+    int width, int height, int bytesPerLine, int layout
+) {
+    for (int y = 0; y < height; ++y) {
+        if (
+            memcmp(
+                a.data() + y*bytesPerLine, b.data() + y*bytesPerLine,
+                width*pixelBytes[layout]
+            ) != 0
+        )
+            return false;
+    }
+    return true;
+}
+
+// importPixels then exportPixels, the rows have a padding
+static void checkConvert(int layout, int width) {
+    const int height = 3;
+    int bytesPerLine = width*pixelBytes[layout] + 5;
+    std::vector<unsigned char> bits, result(bytesPerLine*height);
+    randomPixels(width, height, bytesPerLine, layout, bits);
+    PlanarImage image;
+    importPixels(width, height, bits.data(), bytesPerLine, layout, image, 2);
+    exportPixels(image, result.data(), bytesPerLine, layout, 2);
+    checkPixels(
+        samePixels(bits, result, width, height, bytesPerLine, layout),
+        "import and export", layout, width
+    );
+
+    // NaN gives 0, the alpha of XRGB32 is still 0xFF
+    randomPixels(width, height, bytesPerLine, layout, bits);
+    for (int y = 0; y < height; ++y) {
+        unsigned char* row = bits.data() + y*bytesPerLine;
+        memset(row, 0, width*pixelBytes[layout]);
+        for (int x = 0; layout == PIXELS_XRGB32 && x < width; ++x) {
+            unsigned int p = 0xFF000000u;
+            memcpy(row + 4*x, &p, 4);
+        }
+    }
+    for (int c = 0; c < NUM_PLANES; ++c) {
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x)
+                image.row(c, y)[x] = NAN;
+        }
+    }
+    exportPixels(image, result.data(), bytesPerLine, layout, 2);
+    checkPixels(
+        samePixels(bits, result, width, height, bytesPerLine, layout),
+        "export of NaN", layout, width
+    );
+}
+
+// The fixed point of Bilinear8 against the bilinear filter on floats
+static void checkBilinear8(int width, int height, double zoom) {
+    int bytesPerLine = 4*width;
+    std::vector<unsigned char> bits;
+    randomPixels(width, height, bytesPerLine, PIXELS_XRGB32, bits);
+    ResampleParams params;
+    params.method = METHOD_BILINEAR;
+    params.zoom = zoom;
+    params.numThreads = 3;
+    int resultWidth, resultHeight;
+    resampledSize(params, width, height, resultWidth, resultHeight);
+    if (resultWidth <= 0 || resultHeight <= 0)
+        return;
+    int resultBytesPerLine = 4*resultWidth;
+    std::vector<unsigned char> exact(resultBytesPerLine*resultHeight);
+    std::vector<unsigned char> fixed(exact.size());
+    bool ok = resamplePixels(
+        width, height, bits.data(), bytesPerLine, PIXELS_XRGB32,
+        exact.data(), resultBytesPerLine, PIXELS_XRGB32, params
+    );
+    params.method = METHOD_BILINEAR8;
+    ok = ok && resamplePixels(
+        width, height, bits.data(), bytesPerLine, PIXELS_XRGB32,
+        fixed.data(), resultBytesPerLine, PIXELS_XRGB32, params
+    );
+    int maxDiff = 0;
+    for (size_t i = 0; i < exact.size(); ++i) {
+        int d = abs((int) exact[i] - (int) fixed[i]);
+        if (d > maxDiff)
+            maxDiff = d;
+    }
+    check(ok && maxDiff <= 1, "Bilinear8 against bilinear", params);
+}
+
+int main() {
+    const int sizes[][2] = {{300, 211}, {129, 65}, {7, 5}, {64, 300}};
+    const double zooms[] = {2., 3., 4., 2.5, 1.3, 0.7, 0.3, 0.1};
+    const int numSizes = sizeof(sizes)/sizeof(sizes[0]);
+    const int numZooms = sizeof(zooms)/sizeof(zooms[0]);
+
+    for (int layout = PIXELS_XRGB32; layout <= PIXELS_GRAY8; ++layout) {
+        for (int width = 1; width <= 100; ++width)
+            checkConvert(layout, width);
+    }
+
+    for (int s = 0; s < numSizes; ++s) {
+        for (int z = 0; z < numZooms; ++z)
+            checkBilinear8(sizes[s][0], sizes[s][1], zooms[z]);
+        PlanarImage image;
+        randomImage(sizes[s][0], sizes[s][1], s + 1, image);
+        checkGaussSwitch(image);
+        for (int z = 0; z < numZooms; ++z) {
+            for (int m = 0; m < NUM_RESAMPLE_METHODS; ++m) {
+                ResampleParams params;
+                params.method = m;
+                params.zoom = zooms[z];
+                params.sigma = 1.5;
+                params.radius = 7;
+                params.numThreads = 3;
+                checkRegions(image, params);
+                checkStream(image, params);
+                if (m != METHOD_SPLINE_C2 && m != METHOD_SPLINE_C2D)
+                    continue;
+                // The C2 splines solved by windows are local
+                const double tolerances[] = {1e-2, 1e-4, 1e-6};
+                for (int t = 0; t < 3; ++t) {
+                    params.splineTolerance = tolerances[t];
+                    checkTolerance(image, params);
+                    checkRegions(image, params);
+                    checkStream(image, params);
+                }
+            }
+        }
+    }
+
+    printf("%d checks, %d failed\n", numChecks, numFailures);
+    return (numFailures > 0)? 1 : 0;
+}
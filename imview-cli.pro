@@ -0,0 +1,20 @@
+#-------------------------------------------------
+#
+# Command-line batch resizer: the engines of ImView without
+# the widgets, runs on servers without display
+#
+#-------------------------------------------------
+
+QT       += core gui
+QT       -= widgets
+
+TARGET = imview-cli
+TEMPLATE = app
+CONFIG += console c++11 thread
+CONFIG -= app_bundle
+
+include(engines.pri)
+
+SOURCES += climain.cpp QImagePlanes.cpp
+
+HEADERS += QImagePlanes.h
@@ -0,0 +1,19 @@
+#-------------------------------------------------
+#
+# Checks of the engines without Qt: the regions, the windowed
+# C2 splines and the streaming against the whole results, the 8-bit
+# conversions and Bilinear8. CONFIG+=scalar builds the engines without
+# their SSE2 kernels
+#
+#-------------------------------------------------
+
+TARGET = imview-engines-test
+TEMPLATE = app
+CONFIG += console c++11 thread
+CONFIG -= qt app_bundle
+
+include(engines.pri)
+
+scalar: QMAKE_CXXFLAGS += -U__SSE2__
+
+SOURCES += enginestest.cpp
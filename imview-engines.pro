@@ -0,0 +1,13 @@
+#-------------------------------------------------
+#
+# Library of the image processing engines: resamplers and filters
+# of ImView without Qt (entry point Resampler.h)
+#
+#-------------------------------------------------
+
+TARGET = imview-engines
+TEMPLATE = lib
+CONFIG += staticlib c++11 thread
+CONFIG -= qt
+
+include(engines.pri)
@@ -1,11 +1,19 @@
 #ifndef MAINWINDOW_H
 #define MAINWINDOW_H
 
+#include <memory>
 #include <QMainWindow>
 #include "RealPixel.h"
+#include "PlanarImage.h"
+#include "Resampler.h"
 #include <time.h>
 class DrawArea;
 class MainWindow;
+class ResampleTask;
+class QProgressBar;
+class QPushButton;
+class QCheckBox;
+class QTimer;
 
 extern MainWindow* mainWindow;
 extern DrawArea* drawArea;
@@ -23,40 +31,47 @@ public:
     QImage* image;
     int imageWidth;
     int imageHeight;
-    RealPixel* imageMatrix;
+    // Working copy of the image. The matrices are replaced, not changed:
+    // the running task may still read the old one
+    std::shared_ptr<const PlanarImage> imageMatrix;
     double sigma;
     double radius;
     double zoom;
-    RealPixel p[4][4];
-    // RealPixel a[4][4],p[4][4]; // a is bicubic interpolation coefficients,
-                                  // p is interpol points;
     int modifiedImageWidth;
     int modifiedImageHeight;
-    RealPixel* modifiedMatrix;
+    std::shared_ptr<const PlanarImage> modifiedMatrix;
     QImage* modifiedImage;
+    QImage* previewImage;       // Coarse result of the running task,
+                                // shown instead of modifiedImage
     int testImageIdx;
     int splineType;     // 0 == C2-Spline, 1 == C1-Spline
 
+    // What is done with the result of a task
+    enum TaskTarget {
+        TARGET_MODIFIED,    // modifiedMatrix and modifiedImage
+        TARGET_PREVIEW,     // modifiedImage only
+        TARGET_SOURCE       // The image, its matrix and modifiedImage
+    };
+    ResampleTask* task;     // The running task, 0 -- none
+
     bool loadImage(QString path);
     void defineImageMatrix();
-    void computeModifiedImage(
-        int w, int h, const RealPixel* matrix
-    );
 
-    void createTestImage(int idx);
-    void bilinear_interpolation();
+    // The task is run by the thread pool, the running one is cancelled.
+    // With progressive the task shows its preview first
+    void startTask(ResampleTask* newTask, bool progressive = false);
+    void clearPreview();
 
-    // Bicubic interpolation
-    void   updateCoefficients();
-    RealPixel getValue(double, double);
-    void bicubic_interpolation();
-    RealPixel cubicInterpolate(RealPixel p[], double);
-    RealPixel bicubicInterpolate( //double p[4][4],
-        double x, double y
-    );
+    // With the tiles on, the result of the method is shown by the tiles
+    // of drawArea instead of a task; false if the method is global
+    // (hasLocalRegions)
+    bool showTiles(int method);
+
+    void createTestImage(int idx);
 
-    // Spline interpolation
-    void onSplineInterpolation();
+    // Parameters of the engines library (Resampler.h)
+    // with the zoom, sigma and radius of the window
+    ResampleParams resampleParams(int method) const;
 
     void onPixelMixing();
     void onGaussResize();
@@ -64,6 +79,10 @@ public:
     explicit MainWindow(QWidget *parent = 0);
     ~MainWindow();
 
+public slots:
+    // The running task is cancelled, its result is dropped
+    void cancelTask();
+
 private slots:
     void on_path_returnPressed();
 
@@ -99,15 +118,28 @@ private slots:
 
     void on_saveToClip_clicked();
 
+    // Changes of the parameters cancel the running task
+    void on_coeff_resize_textChanged(const QString&);
+
+    void on_sigma_edit_textChanged(const QString&);
+
+    void on_radius_edit_textChanged(const QString&);
+
+    void on_sigmaSlider_valueChanged(int);
+
+    void onTaskPreview();
+
+    void onTaskFinished();
+
+    void onTaskProgress();
+
 private:
     Ui::MainWindow *ui;
+    QProgressBar* progressBar;  // In the status bar while a task runs
+    QPushButton* cancelButton;
+    QCheckBox* progressiveBox;  // Preview before the slow methods
+    QCheckBox* tilesBox;        // Only the visible part of the result
+    QTimer* progressTimer;
 };
 
-void createGaussPattern(
-    double sigma, int maxSize,
-    int& filterSize,
-    double** filter,
-    double& filterNorm
-);
-
 #endif // MAINWINDOW_H